@@ -73,7 +73,19 @@ void Arrow::paint(QPainter *painter, const QStyleOptionGraphicsItem *,
     QPen myPen = pen();
     qreal arrowSize = 20;
     if (isSelected()&&static_cast<DiagramScene*>(scene())->getRenderSelection()) myPen.setWidth(myPen.width()*2);
-    if (_op->inCriticalPath())
+    double index = static_cast<DiagramScene*>(scene())->model()->getCriticalityIndex(_op);
+    if (index >= 0)
+    {
+        // after a simulation the colour goes from the usual one to the
+        // critical one with the criticality index
+        QColor color = QColor::fromRgbF(
+                myColor.redF() + (myCritColor.redF() - myColor.redF()) * index,
+                myColor.greenF() + (myCritColor.greenF() - myColor.greenF()) * index,
+                myColor.blueF() + (myCritColor.blueF() - myColor.blueF()) * index);
+        painter->setBrush(color);
+        myPen.setColor(color);
+    }
+    else if (_op->inCriticalPath())
     {
         painter->setBrush(myCritColor);
         myPen.setColor(myCritColor);
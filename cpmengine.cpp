@@ -0,0 +1,275 @@
+#include "cpmengine.h"
+#include <QMap>
+
+CpmEngine::CpmEngine() : _length(0)
+{
+}
+
+CpmEngine::CpmEngine(const NetSnapshot &s) : _length(0)
+{
+    calculate(s);
+}
+
+bool CpmEngine::calculate(const NetSnapshot &s)
+{
+    net = s;
+    int n = net.eventCount();
+    const int *ends = net.ends().constData();
+    const double *durations = net.durations().constData();
+    const int *outOffsets = net.outOffsets().constData();
+    const int *outArcs = net.outArcs().constData();
+    const int *inOffsets = net.inOffsets().constData();
+
+    // Kahn's algorithm
+    QVector<int> indegree(n);
+    for (int i = 0; i < n; ++i)
+        indegree[i] = inOffsets[i + 1] - inOffsets[i];
+    _order.clear();
+    _order.reserve(n);
+    for (int i = 0; i < n; ++i)
+    {
+        if (indegree[i] == 0)
+            _order << i;
+    }
+    sources = _order;
+    for (int k = 0; k < _order.count(); ++k)
+    {
+        int i = _order[k];
+        for (int l = outOffsets[i]; l < outOffsets[i + 1]; ++l)
+        {
+            int j = ends[outArcs[l]];
+            if (--indegree[j] == 0)
+                _order << j;
+        }
+    }
+
+    position.fill(-1, n);
+    for (int k = 0; k < _order.count(); ++k)
+        position[_order[k]] = k;
+
+    // forward pass
+    early.fill(0, n);
+    foreach (int i, _order)
+    {
+        double t = early[i];
+        for (int l = outOffsets[i]; l < outOffsets[i + 1]; ++l)
+        {
+            int a = outArcs[l];
+            if (t + durations[a] > early[ends[a]])
+                early[ends[a]] = t + durations[a];
+        }
+    }
+
+    // backward pass
+    tail.fill(0, n);
+    for (int k = _order.count() - 1; k >= 0; --k)
+    {
+        int i = _order[k];
+        for (int l = outOffsets[i]; l < outOffsets[i + 1]; ++l)
+        {
+            int a = outArcs[l];
+            if (durations[a] + tail[ends[a]] > tail[i])
+                tail[i] = durations[a] + tail[ends[a]];
+        }
+    }
+    calcLength();
+    return isAcyclic();
+}
+
+// Events left out of the topological order all have a predecessor
+// that is left out too, so walking back over such predecessors
+// from any of them must come round to an event seen before.
+QVector<int> CpmEngine::loop() const
+{
+    QVector<int> events;
+    if (isAcyclic())
+        return events;
+    int n = net.eventCount();
+    int start = 0;
+    while (position[start] != -1)
+        ++start;
+    QVector<int> step(n, -1);
+    int i = start;
+    while (step[i] == -1)
+    {
+        step[i] = events.count();
+        events << i;
+        for (int l = net.inBegin(i); l < net.inEnd(i); ++l)
+        {
+            int j = net.arcBegin(net.inArc(l));
+            if (position[j] == -1)
+            {
+                i = j;
+                break;
+            }
+        }
+    }
+    // the loop is the tail of the walk starting at i, reversed
+    QVector<int> result;
+    for (int k = events.count() - 1; k >= step[i]; --k)
+        result << events[k];
+    return result;
+}
+
+void CpmEngine::calcLength()
+{
+    // the longest path starts in one of the source events
+    _length = 0;
+    foreach (int i, sources)
+    {
+        if (tail[i] > _length)
+            _length = tail[i];
+    }
+}
+
+double CpmEngine::totalFloat(int a) const
+{
+    return laterTime(net.arcEnd(a)) - earlyTime(net.arcBegin(a)) - net.duration(a);
+}
+
+// An arc is critical when the longest path through it is as long
+// as the net, i.e. its total float is zero.
+bool CpmEngine::isCritical(int a) const
+{
+    double longest = early[net.arcBegin(a)] + net.duration(a) + tail[net.arcEnd(a)];
+    return qFuzzyCompare(longest + 1.0, _length + 1.0);
+}
+
+// Intensity factor of arc (i,j): Kн = (t(Lmax) - t'кр) / (tкр - t'кр),
+// where Lmax is the longest path through the arc and t'кр is the length
+// of its critical arcs. t(Lmax) = early(i) + t(i,j) + tail(j); the
+// critical part is accumulated along the longest paths by the same
+// passes. If several longest paths pass through the arc, the one with
+// the shortest critical part is taken, which gives the higher factor.
+QVector<double> CpmEngine::intensityFactors() const
+{
+    int n = net.eventCount();
+    int m = net.arcCount();
+    const int *begins = net.begins().constData();
+    const int *ends = net.ends().constData();
+    const double *durations = net.durations().constData();
+    const int *outOffsets = net.outOffsets().constData();
+    const int *outArcs = net.outArcs().constData();
+    const int *inOffsets = net.inOffsets().constData();
+    const int *inArcs = net.inArcs().constData();
+
+    QVector<bool> critical(m);
+    for (int a = 0; a < m; ++a)
+        critical[a] = isCritical(a);
+
+    // critical part of the longest path to and from every event
+    QVector<double> headCritical(n, 0), tailCritical(n, 0);
+    foreach (int j, _order)
+    {
+        bool found = false;
+        for (int l = inOffsets[j]; l < inOffsets[j + 1]; ++l)
+        {
+            int b = inArcs[l];
+            if (early[begins[b]] + durations[b] == early[j])
+            {
+                double c = headCritical[begins[b]] + (critical[b] ? durations[b] : 0);
+                if (!found || c < headCritical[j])
+                    headCritical[j] = c;
+                found = true;
+            }
+        }
+    }
+    for (int k = _order.count() - 1; k >= 0; --k)
+    {
+        int i = _order[k];
+        bool found = false;
+        for (int l = outOffsets[i]; l < outOffsets[i + 1]; ++l)
+        {
+            int b = outArcs[l];
+            if (durations[b] + tail[ends[b]] == tail[i])
+            {
+                double c = (critical[b] ? durations[b] : 0) + tailCritical[ends[b]];
+                if (!found || c < tailCritical[i])
+                    tailCritical[i] = c;
+                found = true;
+            }
+        }
+    }
+
+    QVector<double> factors(m, 0);
+    for (int a = 0; a < m; ++a)
+    {
+        if (critical[a])
+        {
+            factors[a] = 1;
+            continue;
+        }
+        double tmax = early[begins[a]] + durations[a] + tail[ends[a]];
+        if (tmax > 0)
+        {
+            double t1cr = headCritical[begins[a]] + tailCritical[ends[a]];
+            factors[a] = (tmax - t1cr) / (_length - t1cr);
+        }
+    }
+    return factors;
+}
+
+void CpmEngine::setDuration(int a, double t)
+{
+    net.setDuration(a, t);
+    if (!isAcyclic())
+    {
+        calculate(net);
+        return;
+    }
+    const int *begins = net.begins().constData();
+    const int *ends = net.ends().constData();
+    const double *durations = net.durations().constData();
+    const int *outOffsets = net.outOffsets().constData();
+    const int *outArcs = net.outArcs().constData();
+    const int *inOffsets = net.inOffsets().constData();
+    const int *inArcs = net.inArcs().constData();
+
+    // Events are taken in topological order (by position), so every
+    // event is recalculated once after all its changed predecessors.
+    QMap<int, int> queue;
+    queue.insert(position[ends[a]], ends[a]);
+    while (!queue.isEmpty())
+    {
+        QMap<int, int>::iterator it = queue.begin();
+        int j = it.value();
+        queue.erase(it);
+        double t = 0;
+        for (int l = inOffsets[j]; l < inOffsets[j + 1]; ++l)
+        {
+            int b = inArcs[l];
+            if (early[begins[b]] + durations[b] > t)
+                t = early[begins[b]] + durations[b];
+        }
+        if (t != early[j])
+        {
+            early[j] = t;
+            for (int l = outOffsets[j]; l < outOffsets[j + 1]; ++l)
+                queue.insert(position[ends[outArcs[l]]], ends[outArcs[l]]);
+        }
+    }
+
+    // and in reverse topological order for tail times
+    queue.insert(position[begins[a]], begins[a]);
+    while (!queue.isEmpty())
+    {
+        QMap<int, int>::iterator it = queue.end();
+        --it;
+        int i = it.value();
+        queue.erase(it);
+        double t = 0;
+        for (int l = outOffsets[i]; l < outOffsets[i + 1]; ++l)
+        {
+            int b = outArcs[l];
+            if (durations[b] + tail[ends[b]] > t)
+                t = durations[b] + tail[ends[b]];
+        }
+        if (t != tail[i])
+        {
+            tail[i] = t;
+            for (int l = inOffsets[i]; l < inOffsets[i + 1]; ++l)
+                queue.insert(position[begins[inArcs[l]]], begins[inArcs[l]]);
+        }
+    }
+    calcLength();
+}
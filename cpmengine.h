@@ -0,0 +1,42 @@
+#ifndef CPMENGINE_H
+#define CPMENGINE_H
+
+#include "netsnapshot.h"
+#include <QVector>
+
+// Critical path method over a net snapshot: one forward and one
+// backward pass in topological order, O(V+E) for all events at once.
+// setDuration() updates the times incrementally: early times are
+// propagated downstream and tail times upstream of the changed arc
+// only while they keep changing.
+class CpmEngine
+{
+public:
+    CpmEngine();
+    explicit CpmEngine(const NetSnapshot &);
+    bool calculate(const NetSnapshot &);
+    void setDuration(int a, double t);
+    const NetSnapshot &snapshot() const {return net;}
+    const QVector<int> &order() const {return _order;}
+    bool isAcyclic() const {return _order.count() == net.eventCount();}
+    QVector<int> loop() const;
+    double length() const {return _length;}
+    double earlyTime(int i) const {return early[i];}
+    double laterTime(int i) const {return _length - tail[i];}
+    double tailTime(int i) const {return tail[i];}
+    double totalFloat(int a) const;
+    bool isCritical(int a) const;
+    QVector<double> intensityFactors() const;
+private:
+    NetSnapshot net;
+    QVector<int> _order;
+    QVector<int> position;
+    QVector<int> sources;
+    // early[i] - the longest path to event i,
+    // tail[i] - the longest path from event i to the end event.
+    QVector<double> early, tail;
+    double _length;
+    void calcLength();
+};
+
+#endif // CPMENGINE_H
@@ -0,0 +1,18 @@
+#include "cpmtask.h"
+
+CpmTask::CpmTask(const NetSnapshot &net, int version) : net(net), version(version)
+{
+    // deleted in the thread it belongs to
+    setAutoDelete(false);
+}
+
+void CpmTask::run()
+{
+    CpmResult result;
+    result.version = version;
+    result.schedule.calculate(net);
+    if (result.schedule.isAcyclic())
+        result.intensity = result.schedule.intensityFactors();
+    emit finished(result);
+    deleteLater();
+}
@@ -0,0 +1,37 @@
+#ifndef CPMTASK_H
+#define CPMTASK_H
+
+#include "cpmengine.h"
+#include <QObject>
+#include <QRunnable>
+#include <QMetaType>
+#include <QVector>
+
+// Schedule of a snapshot calculated in the background, version is
+// the version of the model the snapshot was taken from.
+struct CpmResult
+{
+    int version;
+    CpmEngine schedule;
+    QVector<double> intensity;
+};
+
+Q_DECLARE_METATYPE(CpmResult)
+
+// Calculates a schedule in a thread of QThreadPool. The snapshot is
+// a copy, so the model may change meanwhile. finished() is emitted
+// from that thread and must be connected queued.
+class CpmTask : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    CpmTask(const NetSnapshot &net, int version);
+    void run();
+signals:
+    void finished(const CpmResult &);
+private:
+    NetSnapshot net;
+    int version;
+};
+
+#endif // CPMTASK_H
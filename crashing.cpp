@@ -0,0 +1,342 @@
+#include "crashing.h"
+
+namespace
+{
+
+// Dinic's maximum flow, edges 2k and 2k+1 are the two directions
+// of one edge
+class FlowNetwork
+{
+public:
+    explicit FlowNetwork(int n) : first(n, -1), level(n), current(n) {}
+    int addEdge(int u, int v, double capacity)
+    {
+        addHalf(u, v, capacity);
+        addHalf(v, u, 0);
+        return to.count() - 2;
+    }
+    double flow(int e) const {return capacity[e ^ 1];}
+    void removeEdge(int e)
+    {
+        capacity[e] = 0;
+        capacity[e ^ 1] = 0;
+    }
+    double maxFlow(int s, int t, double epsilon)
+    {
+        this->epsilon = epsilon;
+        double flow = 0;
+        while (levels(s, t))
+        {
+            current = first;
+            for (;;)
+            {
+                double f = augment(s, t, -1);
+                if (f <= epsilon)
+                    break;
+                flow += f;
+            }
+        }
+        return flow;
+    }
+    // nodes reachable from s over edges with residual capacity
+    QVector<bool> reachable(int s) const
+    {
+        QVector<bool> seen(first.count(), false);
+        QVector<int> queue;
+        queue << s;
+        seen[s] = true;
+        for (int k = 0; k < queue.count(); ++k)
+        {
+            for (int e = first[queue[k]]; e != -1; e = next[e])
+            {
+                if (capacity[e] > epsilon && !seen[to[e]])
+                {
+                    seen[to[e]] = true;
+                    queue << to[e];
+                }
+            }
+        }
+        return seen;
+    }
+private:
+    QVector<int> first, next, to;
+    QVector<double> capacity;
+    QVector<int> level, current;
+    double epsilon;
+    void addHalf(int u, int v, double c)
+    {
+        next << first[u];
+        first[u] = to.count();
+        to << v;
+        capacity << c;
+    }
+    bool levels(int s, int t)
+    {
+        level.fill(-1);
+        QVector<int> queue;
+        queue << s;
+        level[s] = 0;
+        for (int k = 0; k < queue.count(); ++k)
+        {
+            for (int e = first[queue[k]]; e != -1; e = next[e])
+            {
+                if (capacity[e] > epsilon && level[to[e]] == -1)
+                {
+                    level[to[e]] = level[queue[k]] + 1;
+                    queue << to[e];
+                }
+            }
+        }
+        return level[t] != -1;
+    }
+    // limit < 0 stands for no limit
+    double augment(int u, int t, double limit)
+    {
+        if (u == t)
+            return limit;
+        for (int &e = current[u]; e != -1; e = next[e])
+        {
+            int v = to[e];
+            if (capacity[e] > epsilon && level[v] == level[u] + 1)
+            {
+                double c = limit < 0 || capacity[e] < limit ? capacity[e] : limit;
+                double f = augment(v, t, c);
+                if (f > epsilon)
+                {
+                    capacity[e] -= f;
+                    capacity[e ^ 1] += f;
+                    return f;
+                }
+            }
+        }
+        return 0;
+    }
+};
+
+}
+
+CrashingOptimizer::CrashingOptimizer(const CpmEngine &schedule, const QVector<double> &crashTimes,
+                                     const QVector<double> &costSlopes) :
+        cpm(schedule), normal(schedule.snapshot().durations()),
+        crashTimes(crashTimes), costSlopes(costSlopes)
+{
+    // every step ends at a breakpoint of the cost curve, where an arc
+    // reaches its crash or normal time or a path becomes critical; a
+    // few of them per arc are expected, more are not converging
+    maxSteps = 4 * (qint64(schedule.snapshot().arcCount()) + 1);
+}
+
+// Minimum cut of the critical subnet between the events the critical
+// paths begin and end in. The flow with lower bounds is found as usual:
+// a feasible flow through a return edge from the end to the begin
+// first, then the most of it from the begin to the end.
+bool CrashingOptimizer::findCut(const QVector<bool> &critical, QVector<int> *forward,
+                                QVector<int> *backward)
+{
+    const NetSnapshot &net = cpm.snapshot();
+    int n = net.eventCount();
+    int m = net.arcCount();
+    int s = n, t = n + 1, feasibleSource = n + 2, feasibleSink = n + 3;
+
+    // any cut with an uncuttable edge costs more than all others
+    double infinity = 1;
+    for (int a = 0; a < m; ++a)
+    {
+        if (critical[a])
+            infinity += costSlopes[a];
+    }
+    double epsilon = infinity * 1e-12;
+
+    FlowNetwork flow(n + 4);
+    QVector<double> excess(n, 0);
+    QVector<bool> linked(n, false);
+    for (int a = 0; a < m; ++a)
+    {
+        if (!critical[a])
+            continue;
+        int i = net.arcBegin(a);
+        int j = net.arcEnd(a);
+        double upper = net.duration(a) > crashTimes[a] ? costSlopes[a] : infinity;
+        double lower = net.duration(a) < normal[a] ? costSlopes[a] : 0;
+        flow.addEdge(i, j, upper - lower);
+        excess[i] -= lower;
+        excess[j] += lower;
+        if (!linked[i] && cpm.earlyTime(i) == 0)
+        {
+            flow.addEdge(s, i, infinity);
+            linked[i] = true;
+        }
+        if (!linked[j] && cpm.tailTime(j) == 0)
+        {
+            flow.addEdge(j, t, infinity);
+            linked[j] = true;
+        }
+    }
+    double required = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        if (excess[i] > 0)
+        {
+            flow.addEdge(feasibleSource, i, excess[i]);
+            required += excess[i];
+        }
+        else if (excess[i] < 0)
+            flow.addEdge(i, feasibleSink, -excess[i]);
+    }
+    int back = flow.addEdge(t, s, infinity);
+    // the crashed arcs can not carry their lower bounds when the
+    // schedule is not the cheapest one for its length
+    if (flow.maxFlow(feasibleSource, feasibleSink, epsilon) < required - epsilon)
+        return false;
+    double value = flow.flow(back);
+    flow.removeEdge(back);
+    value += flow.maxFlow(s, t, epsilon);
+    if (value >= infinity)
+        return false;
+    QVector<bool> reached = flow.reachable(s);
+    for (int a = 0; a < m; ++a)
+    {
+        if (!critical[a])
+            continue;
+        bool begin = reached[net.arcBegin(a)];
+        bool end = reached[net.arcEnd(a)];
+        if (begin && !end)
+            *forward << a;
+        else if (!begin && end && net.duration(a) < normal[a])
+            *backward << a;
+    }
+    return true;
+}
+
+// Slope of the longest path: the sum of the changes of its arcs. The
+// path is traced from the source with the longest tail time along the
+// arcs the tail times come from.
+int CrashingOptimizer::longestSlope(const QVector<int> &change) const
+{
+    const NetSnapshot &net = cpm.snapshot();
+    // the sources come first in the topological order
+    int i = -1;
+    foreach (int j, cpm.order())
+    {
+        if (net.inBegin(j) != net.inEnd(j))
+            break;
+        if (i == -1 || cpm.tailTime(j) > cpm.tailTime(i))
+            i = j;
+    }
+    int slope = 0;
+    while (i != -1 && net.outBegin(i) != net.outEnd(i))
+    {
+        int best = -1;
+        double longest = 0;
+        for (int k = net.outBegin(i); k < net.outEnd(i); ++k)
+        {
+            int a = net.outArc(k);
+            double l = net.duration(a) + cpm.tailTime(net.arcEnd(a));
+            if (best == -1 || l > longest || (l == longest && change[a] > change[best]))
+            {
+                best = a;
+                longest = l;
+            }
+        }
+        slope += change[best];
+        i = net.arcEnd(best);
+    }
+    return slope;
+}
+
+// Changes the cut arcs by the step, shortened until the critical paths
+// are still the longest ones. The schedule is updated incrementally,
+// a path longer than the critical ones after the step gives the step
+// it meets them at. Returns the step taken, 0 if none could be taken.
+double CrashingOptimizer::takeStep(const QVector<int> &cut, const QVector<int> &change, double step)
+{
+    const NetSnapshot &net = cpm.snapshot();
+    double length = cpm.length();
+    QVector<double> base;
+    foreach (int a, cut)
+        base << net.duration(a);
+    for (int iteration = 0; iteration <= net.arcCount() && step > 0; ++iteration)
+    {
+        for (int k = 0; k < cut.count(); ++k)
+        {
+            int a = cut[k];
+            double t = base[k] + change[a] * step;
+            if (t < crashTimes[a])
+                t = crashTimes[a];
+            if (t > normal[a])
+                t = normal[a];
+            cpm.setDuration(a, t);
+        }
+        double longest = cpm.length();
+        if (longest <= length - step || qFuzzyCompare(longest + 1.0, length - step + 1.0))
+            return step;
+        // longest - slope * step is the length of that path before
+        int slope = longestSlope(change);
+        if (slope + 1 <= 0)
+            break;
+        step = (length - longest + slope * step) / (slope + 1);
+    }
+    for (int k = 0; k < cut.count(); ++k)
+        cpm.setDuration(cut[k], base[k]);
+    return 0;
+}
+
+CrashingPlan CrashingOptimizer::run(double target)
+{
+    CrashingPlan plan;
+    const NetSnapshot &net = cpm.snapshot();
+    int m = net.arcCount();
+    QVector<bool> critical(m);
+    QVector<int> change(m, 0);
+    qint64 steps = 0;
+    for (;;)
+    {
+        double length = cpm.length();
+        if (length <= target)
+        {
+            plan.reached = true;
+            break;
+        }
+        if (steps == maxSteps)
+        {
+            plan.converged = false;
+            break;
+        }
+        ++steps;
+        for (int a = 0; a < m; ++a)
+            critical[a] = cpm.isCritical(a);
+        QVector<int> forward, backward;
+        if (!findCut(critical, &forward, &backward) || forward.isEmpty())
+            break;
+        double step = length - target;
+        foreach (int a, forward)
+        {
+            if (net.duration(a) - crashTimes[a] < step)
+                step = net.duration(a) - crashTimes[a];
+            change[a] = -1;
+        }
+        foreach (int a, backward)
+        {
+            if (normal[a] - net.duration(a) < step)
+                step = normal[a] - net.duration(a);
+            change[a] = 1;
+        }
+        QVector<int> cut = forward;
+        cut += backward;
+        step = takeStep(cut, change, step);
+        foreach (int a, cut)
+            change[a] = 0;
+        if (step <= 0)
+            break;
+    }
+    plan.length = cpm.length();
+    for (int a = 0; a < m; ++a)
+    {
+        if (net.duration(a) != normal[a])
+        {
+            plan.durations.insert(net.operation(a), net.duration(a));
+            plan.cost += costSlopes[a] * (normal[a] - net.duration(a));
+        }
+    }
+    return plan;
+}
@@ -0,0 +1,66 @@
+#ifndef CRASHING_H
+#define CRASHING_H
+
+#include "cpmengine.h"
+#include <QHash>
+#include <QVector>
+
+// Shortest duration an operation can be crashed to and the cost
+// of every unit of time it is shortened by.
+struct CrashOption
+{
+    double crashTime;
+    double costSlope;
+    CrashOption() : crashTime(0), costSlope(0) {}
+    CrashOption(double crashTime, double costSlope) : crashTime(crashTime), costSlope(costSlope) {}
+};
+
+// Crashed durations of operations and what they cost,
+// see CrashingOptimizer.
+struct CrashingPlan
+{
+    // new durations of the shortened operations only
+    QHash<Operation*, double> durations;
+    double cost;
+    double length;
+    // false if the target could not be reached, the plan then gives
+    // the shortest length found
+    bool reached;
+    // false if the steps ran out before the target or the shortest
+    // length was found
+    bool converged;
+    // false if an option was rejected: a negative cost slope or crash
+    // time, or a crash time above the duration of the operation
+    bool valid;
+    CrashingPlan() : cost(0), length(0), reached(false), converged(true), valid(true) {}
+};
+
+// Time-cost tradeoff of a net by the Phillips-Dessouky method. Every
+// step shortens all critical paths at once along the cheapest cut of
+// the critical subnet: the arcs cut forward are crashed, the already
+// crashed arcs cut backward are lengthened back and refund their cost.
+// The cut is the minimum cut of a flow with the cost slope of an arc
+// as the upper bound while it can be crashed and as the lower bound
+// once it has been crashed, so a cut costs the slopes of its forward
+// arcs less the slopes of its crashed backward arcs. The step is as
+// long as the target, the crash and normal times of the cut arcs and
+// the other paths allow. The schedule is updated incrementally by
+// CpmEngine::setDuration for every changed arc.
+class CrashingOptimizer
+{
+public:
+    // crash times and cost slopes are given per arc of the schedule,
+    // the schedule must be acyclic
+    CrashingOptimizer(const CpmEngine &schedule, const QVector<double> &crashTimes,
+                      const QVector<double> &costSlopes);
+    CrashingPlan run(double target);
+private:
+    CpmEngine cpm;
+    QVector<double> normal, crashTimes, costSlopes;
+    qint64 maxSteps;
+    bool findCut(const QVector<bool> &critical, QVector<int> *forward, QVector<int> *backward);
+    int longestSlope(const QVector<int> &change) const;
+    double takeStep(const QVector<int> &cut, const QVector<int> &change, double step);
+};
+
+#endif // CRASHING_H
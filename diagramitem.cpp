@@ -57,6 +57,18 @@ void DiagramItem::removeArrows()
     assert(arrows.count()==0);
 }
 
+// Drops all the given arrows in one pass over the item's arrows.
+void DiagramItem::removeArrows(const QSet<Arrow *> &removed)
+{
+    QList<Arrow *> kept;
+    foreach (Arrow *arrow, arrows)
+    {
+        if (!removed.contains(arrow))
+            kept << arrow;
+    }
+    arrows = kept;
+}
+
 void DiagramItem::addArrow(Arrow *arrow)
 {
     arrows.append(arrow);
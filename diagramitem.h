@@ -3,6 +3,7 @@
 
 #include <QGraphicsPixmapItem>
 #include <QList>
+#include <QSet>
 #include <QBrush>
 #include <QPen>
 #include <QObject>
@@ -37,6 +38,7 @@ public:
 
     void removeArrow(Arrow *arrow);
     void removeArrows();
+    void removeArrows(const QSet<Arrow *> &removed);
     DiagramType diagramType() const
         { return myDiagramType; }
     QPolygonF polygon() const
@@ -53,12 +53,14 @@ void DiagramScene::setModel(NetModel* model)
     connect(model, SIGNAL(eventIdChanged (Event *, const int)), this, SLOT(NChanged(Event *, int)));
     connect(model, SIGNAL(afterEventAdd()), this, SLOT(EventAdd()));
     connect(model, SIGNAL(afterEventInsert(int)), this, SLOT(EventAdd(int)));
-    connect(model, SIGNAL(updated()),this,SLOT(update()));
+    connect(model, SIGNAL(modelChanged(const ModelDelta &)), this, SLOT(modelChanged(const ModelDelta &)));
     connect(model, SIGNAL(beforeClear()),this,SLOT(clearModel()));
     connect(model, SIGNAL(afterOperationInsert(Operation*,int)), this, SLOT(ArrowAdd(Operation*,int)));
     connect(model, SIGNAL(afterOperationAdd(Operation*)), this, SLOT(ArrowAdd(Operation*)));
     connect(model, SIGNAL(beforeOperationDelete(Operation*)), this, SLOT(ArrowDel(Operation*)));
     connect(model, SIGNAL(beforeEventDelete(Event*)), this, SLOT(EventDel(Event*)));
+    connect(model, SIGNAL(beforeItemsDelete(const QList<Event*> &, const QList<Operation*> &)),
+            this, SLOT(ItemsDel(const QList<Event*> &, const QList<Operation*> &)));
     connect(model, SIGNAL(operationEndEventChanged(Operation*,Event*)), this, SLOT(OperationRedirect(Operation*,Event*)));
     connect(this, SIGNAL(selectionChanged()), this, SLOT(onSelectionChange()));
 }
@@ -131,6 +133,51 @@ void DiagramScene::EventDel(Event *ev)
     removeEvent(di);
 }
 
+// Removes the items of many events and operations with one pass over
+// each list instead of a lookup per item.
+void DiagramScene::ItemsDel(const QList<Event*> &events, const QList<Operation*> &operations)
+{
+    QSet<Operation*> operationSet = operations.toSet();
+    QSet<Event*> eventSet = events.toSet();
+    QSet<Arrow*> removedArrows;
+    QSet<DiagramItem*> touchedItems;
+    QList<Arrow*> keptArrows;
+    foreach (Arrow *arr, darrows)
+    {
+        if (!operationSet.contains(arr->getOperation()))
+        {
+            keptArrows << arr;
+            continue;
+        }
+        removedArrows.insert(arr);
+        touchedItems.insert(arr->startItem());
+        if (arr->endItem())
+            touchedItems.insert(arr->endItem());
+    }
+    foreach (DiagramItem *di, touchedItems)
+        di->removeArrows(removedArrows);
+    foreach (Arrow *arr, removedArrows)
+    {
+        arr->invalidate();
+        arr->deleteLater();
+    }
+    darrows = keptArrows;
+
+    QList<DiagramItem*> keptEvents;
+    foreach (DiagramItem *di, devents)
+    {
+        if (eventSet.contains(di->event()))
+        {
+            di->invalidate();
+            di->deleteLater();
+        }
+        else
+            keptEvents << di;
+    }
+    devents = keptEvents;
+    update();
+}
+
 void DiagramScene::debugDump()
 {
     qDebug() << "children" << items().count();
@@ -191,6 +238,31 @@ void DiagramScene::OperationRedirect(Operation *op, Event *)
     } else arr->setEndItem(0);
 }
 
+// Only the items of changed events and operations are repainted,
+// unless the net itself or the event numbers have changed.
+void DiagramScene::modelChanged(const ModelDelta &delta)
+{
+    if (delta.structureChanged || delta.numbersChanged || delta.criticalityIndexChanged)
+    {
+        update();
+        return;
+    }
+    foreach (Arrow *arrow, darrows)
+    {
+        Operation *op = arrow->getOperation();
+        if (delta.changedOperations.contains(op) || delta.criticalityChanged.contains(op))
+            arrow->update();
+    }
+    if (!delta.changedEvents.isEmpty())
+    {
+        foreach (DiagramItem *item, devents)
+        {
+            if (delta.changedEvents.contains(item->event()))
+                item->update();
+        }
+    }
+}
+
 void DiagramScene::editing(bool r)
 {
     emit actionsEnabled(!r);
@@ -200,29 +272,24 @@ void DiagramScene::deleteItem()
 {
     QGraphicsItem* gi = focusItem();
     if (dynamic_cast<DiagramTextItem*>(gi)) return;
-     foreach (QGraphicsItem *item, selectedItems()) {
-         if (item->type()==DiagramItem::Type)
-         {
-             DiagramItem* di =  qgraphicsitem_cast<DiagramItem *>(item);
-             if (di->diagramType()==DiagramItem::Circle) {
-                 Event * eve = di->event();
-                 foreach(Operation *op,eve->getOutOperations())
-                 {
-                     _model->removeOperation(op);
-                 }
-                 foreach(Operation *op,eve->getInOperations())
-                 {
-                     _model->removeOperation(op);
-                 }
-                 _model->removeEvent(di->event());
-             }
-         } else
-         if (item->type()==Arrow::Type)
-         {
-             Arrow* di =  qgraphicsitem_cast<Arrow *>(item);
-             _model->removeOperation(di->getOperation());
-         }
+    // the items are removed by the model at once, their arrows
+    // go away with events
+    QList<Event*> events;
+    QList<Operation*> operations;
+    foreach (QGraphicsItem *item, selectedItems()) {
+        if (item->type()==DiagramItem::Type)
+        {
+            DiagramItem* di =  qgraphicsitem_cast<DiagramItem *>(item);
+            if (di->diagramType()==DiagramItem::Circle)
+                events << di->event();
+        } else
+        if (item->type()==Arrow::Type)
+        {
+            Arrow* di =  qgraphicsitem_cast<Arrow *>(item);
+            operations << di->getOperation();
+        }
     }
+    _model->removeItems(events, operations);
 }
 
 void DiagramScene::setLineColor(const QColor &color)
@@ -359,9 +426,16 @@ void DiagramScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent)
             Event * se = startItem->event();
             Event * ee = endItem->event();
             Operation *op = _model->getOperationByEvents(se,ee);
-            if (op==NULL)
+            if (op==NULL && _model->createsLoop(se, ee))
+            {
+                QMessageBox::warning(views().value(0),
+                                     QString::fromUtf8("Ошибка"),
+                                     QString::fromUtf8("Работа %1 - %2 образует цикл")
+                                     .arg(se->getN()).arg(ee->getN()));
+            }
+            else if (op==NULL)
             {
-                Operation *op = new Operation();
+                Operation *op = _model->createOperation();
                 _model->connect(se, op, ee);
                 _model->addOperation(op);
             }
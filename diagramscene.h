@@ -53,6 +53,7 @@ public slots:
     void ArrowAdd(Operation* op,int);
     void ArrowAdd(Operation* op);
     void ArrowDel(Operation* op);
+    void ItemsDel(const QList<Event*> &events, const QList<Operation*> &operations);
     void OperationRedirect(Operation *op, Event* ev);
     void NChanged(Event *ev, int id);
     void deleteItem();
@@ -79,6 +80,7 @@ private slots:
     void debugDump();
     void onChange(const QList<QRectF> & region);
     void onSelectionChange();
+    void modelChanged(const ModelDelta &);
 private:
     bool isItemChange(int type);
 
@@ -5,8 +5,7 @@
 #include <QImage>
 
 Dialog::Dialog(NetModel &netmodel, QWidget *parent)
-    : QDialog(parent), ui(new Ui::Dialog),
-    eventsList(NULL), operationsList(NULL), pathes(NULL)
+    : QDialog(parent), ui(new Ui::Dialog), pathes(NULL), pathesCount(0), pathesLimit(1000)
 {
     ui->setupUi(this);
     _setModel(netmodel);
@@ -31,8 +30,8 @@ void Dialog::_clearModel()
 {
     clearCache();
     disconnect(netmodel, SIGNAL(beforeClear()), this, SLOT(beforeClear()));
-    disconnect(netmodel, SIGNAL(updated()), this, SLOT(clearCache()));
-    disconnect(netmodel, SIGNAL(updated()), this, SLOT(display()));
+    disconnect(netmodel, SIGNAL(modelChanged(const ModelDelta &)),
+               this, SLOT(modelChanged(const ModelDelta &)));
     netmodel = NULL;
 }
 
@@ -40,8 +39,19 @@ void Dialog::_setModel(NetModel &netmodel)
 {
     this->netmodel = &netmodel;
     connect(&netmodel, SIGNAL(beforeClear()), this, SLOT(beforeClear()));
-    connect(&netmodel, SIGNAL(updated()), this, SLOT(clearCache()));
-    connect(&netmodel, SIGNAL(updated()), this, SLOT(display()));
+    connect(&netmodel, SIGNAL(modelChanged(const ModelDelta &)),
+            this, SLOT(modelChanged(const ModelDelta &)));
+}
+
+// Names are not shown in the tables, so renaming does not
+// rebuild them.
+void Dialog::modelChanged(const ModelDelta &delta)
+{
+    if (delta.scheduleChanged() || delta.numbersChanged || delta.criticalityIndexChanged)
+    {
+        clearCache();
+        display();
+    }
 }
 
 void Dialog::display()
@@ -78,7 +88,15 @@ void Dialog::display()
 
         fillFullPathesData(header, data);
         ui->textBrowser->setAlignment(Qt::AlignCenter);
-        cursor.insertText(QString::fromUtf8("Расчет полных путей"), format);
+        // the count saturates at the maximum of quint64
+        if (pathes == &longestPathes && pathesCount == Q_UINT64_C(0xFFFFFFFFFFFFFFFF))
+            cursor.insertText(QString::fromUtf8("Расчет полных путей (%1 самых длинных из более чем %2)")
+                              .arg(longestPathes.count()).arg((double)pathesCount, 0, 'g', 3), format);
+        else if (pathes == &longestPathes)
+            cursor.insertText(QString::fromUtf8("Расчет полных путей (%1 самых длинных из %2)")
+                              .arg(longestPathes.count()).arg(pathesCount), format);
+        else
+            cursor.insertText(QString::fromUtf8("Расчет полных путей"), format);
         displayTable(cursor, header, data);
 
         cursor.setPosition(topFrame->lastPosition());
@@ -123,7 +141,17 @@ void Dialog::fillFullPathesData(QList<QVariant> &header, QList< QList<QVariant>
     header << "L" << "t(L)" << "R(L)";
     data.clear();
     if (!pathes)
-        pathes = netmodel->getFullPathes();
+    {
+        // the full list may be too large to build, count it first
+        pathesCount = netmodel->countPathes();
+        if (pathesCount > (quint64)pathesLimit)
+        {
+            longestPathes = netmodel->getLongestPathes(pathesLimit);
+            pathes = &longestPathes;
+        }
+        else
+            pathes = netmodel->getFullPathes();
+    }
     foreach (Path p, *pathes)
     {
         QList<QVariant> row;
@@ -140,15 +168,14 @@ void Dialog::fillEventsData(QList<QVariant> &header, QList< QList<QVariant> > &d
     header.clear();
     header << "i" << QString::fromUtf8("t р.(i)") << QString::fromUtf8("t п.(i)") << "R(i)";
     data.clear();
-    if (!eventsList)
-        eventsList = netmodel->getSortedEvents();
-    foreach (Event *e, *eventsList)
+    const NetMetrics *metrics = netmodel->getMetrics();
+    for (int i = 0; i < metrics->events.count(); ++i)
     {
         QList<QVariant> row;
-        row << e->getN();
-        row << FORMAT(netmodel->getEarlyEndTime(e));
-        row << FORMAT(netmodel->getLaterEndTime(e));
-        row << FORMAT(netmodel->getReserveTime(e));
+        row << metrics->events[i]->getN();
+        row << FORMAT(metrics->eventEarly[i]);
+        row << FORMAT(metrics->eventLater[i]);
+        row << FORMAT(metrics->eventReserve[i]);
         data << row;
     }
 }
@@ -161,21 +188,26 @@ void Dialog::fillOperationsData(QList<QVariant> &header, QList< QList<QVariant>
             << QString::fromUtf8("t п.н.(i-j)") << QString::fromUtf8("t р.о.(i-j)")
             << QString::fromUtf8("t п.о.(i-j)") << QString::fromUtf8("R п.(i-j)")
             << QString::fromUtf8("R с.(i-j)") << QString::fromUtf8("K н.(i-j)");
+    // the criticality index is known after a simulation only
+    bool simulated = netmodel->hasCriticalityIndex();
+    if (simulated)
+        header << QString::fromUtf8("K кр.(i-j)");
     data.clear();
-    if (!operationsList)
-        operationsList = netmodel->getSortedOperatioins();
-    foreach (Operation *o, *operationsList)
+    const NetMetrics *metrics = netmodel->getMetrics();
+    for (int i = 0; i < metrics->operations.count(); ++i)
     {
         QList<QVariant> row;
-        row << o->getCode();
-        row << FORMAT(o->getWaitTime());
-        row << FORMAT(netmodel->getEarlyStartTime(o));
-        row << FORMAT(netmodel->getLaterStartTime(o));
-        row << FORMAT(netmodel->getEarlyEndTime(o));
-        row << FORMAT(netmodel->getLaterEndTime(o));
-        row << FORMAT(netmodel->getFullReserveTime(o));
-        row << FORMAT(netmodel->getFreeReserveTime(o));
-        row << FORMAT(netmodel->getIntensityFactor(o));
+        row << metrics->operations[i]->getCode();
+        row << FORMAT(metrics->duration[i]);
+        row << FORMAT(metrics->earlyStart[i]);
+        row << FORMAT(metrics->laterStart[i]);
+        row << FORMAT(metrics->earlyEnd[i]);
+        row << FORMAT(metrics->laterEnd[i]);
+        row << FORMAT(metrics->fullReserve[i]);
+        row << FORMAT(metrics->freeReserve[i]);
+        row << FORMAT(metrics->intensity[i]);
+        if (simulated)
+            row << FORMAT(netmodel->getCriticalityIndex(metrics->operations[i]));
         data << row;
     }
 }
@@ -2,6 +2,7 @@
 #define DIALOG_H
 
 #include "netmodel.h"
+#include "netmetrics.h"
 #include "ui_dialog.h"
 #include <QDialog>
 #include <QTextCursor>
@@ -21,6 +22,9 @@ public:
     Dialog(NetModel &, QWidget *parent = 0);
     ~Dialog();
     void setModel(NetModel &);
+    // above this number of full paths only the longest ones are shown
+    void setPathesLimit(int limit) {pathesLimit = limit; clearCache(); display();}
+    int getPathesLimit() const {return pathesLimit;}
     void printModel()
     {
     }
@@ -38,9 +42,10 @@ public:
 private:
     Ui::Dialog *ui;
     NetModel *netmodel;
-    QList<Event*> *eventsList;
-    QList<Operation*> *operationsList;
     QList<Path> *pathes;
+    QList<Path> longestPathes;
+    quint64 pathesCount;
+    int pathesLimit;
 
     void fillFullPathesData(QList<QVariant> &header, QList< QList<QVariant> > &data);
     void fillEventsData(QList<QVariant> &header, QList< QList<QVariant> > &data);
@@ -51,23 +56,15 @@ private:
     void _setModel(NetModel &);
 private slots:
     void beforeClear();
+    void modelChanged(const ModelDelta &);
     void display();
     void clearCache()
     {
-        if (eventsList)
-        {
-            delete eventsList;
-            eventsList = NULL;
-        }
-        if (operationsList)
-        {
-            delete operationsList;
-            operationsList = NULL;
-        }
         if (pathes)
         {
             pathes = NULL;
         }
+        longestPathes.clear();
     }
 };
 
@@ -0,0 +1,34 @@
+#include "idallocator.h"
+
+IdAllocator::IdAllocator() : bound(0)
+{
+}
+
+int IdAllocator::next()
+{
+    while (!freed.empty() && used.contains(freed.top()))
+        freed.pop();
+    if (!freed.empty())
+        return freed.top();
+    while (used.contains(bound))
+        ++bound;
+    return bound;
+}
+
+void IdAllocator::use(int n)
+{
+    used.insert(n);
+}
+
+void IdAllocator::release(int n)
+{
+    if (used.remove(n) && n < bound)
+        freed.push(n);
+}
+
+void IdAllocator::clear()
+{
+    used.clear();
+    freed = std::priority_queue<int, std::vector<int>, std::greater<int> >();
+    bound = 0;
+}
@@ -0,0 +1,26 @@
+#ifndef IDALLOCATOR_H
+#define IDALLOCATOR_H
+
+#include <QSet>
+#include <vector>
+#include <queue>
+#include <functional>
+
+// Gives the smallest non-negative number that is not in use.
+// Every free number below bound is kept in a min-heap, numbers
+// taken again by use() are skipped when they come to the top.
+class IdAllocator
+{
+public:
+    IdAllocator();
+    int next();
+    void use(int n);
+    void release(int n);
+    void clear();
+private:
+    QSet<int> used;
+    std::priority_queue<int, std::vector<int>, std::greater<int> > freed;
+    int bound;
+};
+
+#endif // IDALLOCATOR_H
@@ -4,6 +4,7 @@
 #include "treeitem.h"
 #include "positioning.h"
 #include "diagramscene.h"
+#include "montecarlo.h"
 #include <QFileDialog>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -19,6 +20,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->btnInsertOperation, SIGNAL(clicked()), this, SLOT(insertOperation()));
     connect(ui->btnDeleteOperation, SIGNAL(clicked()), this, SLOT(deleteOperation()));
     connect(ui->btnCalc, SIGNAL(clicked()), this, SLOT(calc()));
+    connect(ui->btnSimulate, SIGNAL(clicked()), this, SLOT(simulate()));
     connect(ui->actionNew, SIGNAL(triggered()), this, SLOT(newModel()));
     connect(ui->actionOpen, SIGNAL(triggered()), this, SLOT(open()));
     connect(ui->actionSave, SIGNAL(triggered()), this, SLOT(save()));
@@ -30,22 +32,27 @@ MainWindow::MainWindow(QWidget *parent)
     // register types
     qRegisterMetaType<Event*>("Event*");
     qRegisterMetaType<Operation*>("Operation*");
+    // the critical path of a changed net is found in the thread pool,
+    // the views are updated when it comes back
+    netmodel.setAsync(true);
     // setup test netmodel
+    netmodel.beginTransaction();
     netmodel.addEvent();
     Event *e1 = netmodel.last();
     netmodel.addEvent();
     Event *e2 = netmodel.last();
     netmodel.addEvent();
     Event *e3 = netmodel.last();
-    Operation *o1 = new Operation(1);
-    Operation *o2 = new Operation(2);
-    Operation *o3 = new Operation(3);
+    Operation *o1 = netmodel.createOperation(1);
+    Operation *o2 = netmodel.createOperation(2);
+    Operation *o3 = netmodel.createOperation(3);
     netmodel.connect(e1,o2,e2);
     netmodel.connect(e1,o3,e3);
     netmodel.connect(e2,o1,e3);
     netmodel.addOperation(o1);
     netmodel.addOperation(o2);
     netmodel.addOperation(o3);
+    netmodel.commit();
     // setup position of netmodel
     Position *pos = new PlanarPosition;
     pos->position(&netmodel);
@@ -315,6 +322,30 @@ void MainWindow::calc()
     dialog->show();
 }
 
+// The criticality indexes are shown in the tables and on the arrows
+// until the model is changed.
+void MainWindow::simulate()
+{
+    QString error;
+    if (!netmodel.isCorrect(error))
+    {
+        QMessageBox::critical(this,
+                              QString::fromUtf8("Моделирование"),
+                              error);
+        return;
+    }
+    SimulationResult result = netmodel.simulate(10000);
+    dialog->show();
+    QMessageBox::information(this,
+                             QString::fromUtf8("Моделирование"),
+                             QString::fromUtf8("Срок выполнения по %1 испытаниям:\n"
+                                               "среднее %2, отклонение %3\n"
+                                               "P50 %4, P80 %5, P95 %6")
+                             .arg(result.iterations).arg(result.mean).arg(result.deviation)
+                             .arg(result.percentile(0.5)).arg(result.percentile(0.8))
+                             .arg(result.percentile(0.95)));
+}
+
 void MainWindow::insertEvent()
 {
     QModelIndex selected = ui->treeView->selectionModel()->currentIndex();
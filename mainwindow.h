@@ -55,6 +55,7 @@ private slots:
     void insertOperation();
     void deleteOperation();
     void calc();
+    void simulate();
     void currentChanged(const QModelIndex &, const QModelIndex &);
 
     void newModel();
@@ -0,0 +1,72 @@
+#ifndef MODELDELTA_H
+#define MODELDELTA_H
+
+#include <QSet>
+
+class Event;
+class Operation;
+
+// Changes of a net between two NetModel::modelChanged() signals.
+// Removed events and operations are already destroyed, their pointers
+// may only be compared. An item added and removed in between is in
+// neither set, and no pointer is in both the added and the removed
+// set: the model reuses the memory of destroyed items, a new item in
+// place of a removed one is only added.
+struct ModelDelta
+{
+    QSet<Event*> addedEvents, removedEvents, changedEvents;
+    QSet<Operation*> addedOperations, removedOperations, changedOperations;
+    // operations that got in or out of the critical path
+    QSet<Operation*> criticalityChanged;
+    // events or operations were added, removed or connected
+    bool structureChanged;
+    bool durationsChanged;
+    // optimistic or pessimistic times, the schedule is the same
+    bool estimatesChanged;
+    // criticality indexes were simulated or became out of date
+    bool criticalityIndexChanged;
+    bool numbersChanged;
+    bool namesChanged;
+    ModelDelta() :
+            structureChanged(false), durationsChanged(false), estimatesChanged(false),
+            criticalityIndexChanged(false), numbersChanged(false), namesChanged(false)
+    {
+    }
+    // times and reserves may be different
+    bool scheduleChanged() const {return structureChanged || durationsChanged;}
+    void clear() {*this = ModelDelta();}
+
+    // bookkeeping of NetModel, keeps the rules above
+    void eventAdded(Event *e)
+    {
+        if (removedEvents.remove(e))
+            replacedEvents.insert(e);
+        addedEvents.insert(e);
+    }
+    void eventRemoved(Event *e)
+    {
+        if (!addedEvents.remove(e) || replacedEvents.remove(e))
+            removedEvents.insert(e);
+        changedEvents.remove(e);
+    }
+    void operationAdded(Operation *o)
+    {
+        if (removedOperations.remove(o))
+            replacedOperations.insert(o);
+        addedOperations.insert(o);
+    }
+    void operationRemoved(Operation *o)
+    {
+        if (!addedOperations.remove(o) || replacedOperations.remove(o))
+            removedOperations.insert(o);
+        changedOperations.remove(o);
+        criticalityChanged.remove(o);
+    }
+private:
+    // added items in place of removed ones, removed again they are
+    // the removed ones for views
+    QSet<Event*> replacedEvents;
+    QSet<Operation*> replacedOperations;
+};
+
+#endif // MODELDELTA_H
@@ -0,0 +1,301 @@
+#include "montecarlo.h"
+#include <QList>
+#include <QtAlgorithms>
+#include <QtConcurrentMap>
+#include <math.h>
+
+double SimulationResult::percentile(double p) const
+{
+    if (lengths.isEmpty())
+        return 0;
+    int k = (int)ceil(p * lengths.count()) - 1;
+    if (k < 0)
+        k = 0;
+    if (k >= lengths.count())
+        k = lengths.count() - 1;
+    return lengths[k];
+}
+
+QVector<int> SimulationResult::histogram(int bins) const
+{
+    QVector<int> counts(bins, 0);
+    if (lengths.isEmpty() || bins <= 0)
+        return counts;
+    double low = lengths.first();
+    double width = (lengths.last() - low) / bins;
+    foreach (double t, lengths)
+    {
+        int k = width > 0 ? (int)((t - low) / width) : 0;
+        ++counts[k < bins ? k : bins - 1];
+    }
+    return counts;
+}
+
+namespace
+{
+
+// xorshift64* generator, seeded through splitmix64 so that
+// neighbouring seeds give unrelated streams
+class Random
+{
+public:
+    explicit Random(quint64 seed) : hasSpare(false)
+    {
+        quint64 z = seed + Q_UINT64_C(0x9E3779B97F4A7C15);
+        z = (z ^ (z >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+        z = (z ^ (z >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+        state = z ^ (z >> 31);
+        if (state == 0)
+            state = 1;
+    }
+    quint64 next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * Q_UINT64_C(2685821657736338717);
+    }
+    // uniform in (0, 1)
+    double uniform()
+    {
+        return ((next() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+    // standard normal, polar method, which gives two at a time
+    double normal()
+    {
+        if (hasSpare)
+        {
+            hasSpare = false;
+            return spare;
+        }
+        double u, v, s;
+        do
+        {
+            u = 2 * uniform() - 1;
+            v = 2 * uniform() - 1;
+            s = u * u + v * v;
+        }
+        while (s >= 1 || s == 0);
+        double f = sqrt(-2 * log(s) / s);
+        spare = v * f;
+        hasSpare = true;
+        return u * f;
+    }
+    // gamma with shape k >= 1 (Marsaglia and Tsang),
+    // d = k - 1/3 and c = 1/sqrt(9d) are given
+    double gamma(double d, double c)
+    {
+        for (;;)
+        {
+            double x = normal();
+            double v = 1 + c * x;
+            if (v <= 0)
+                continue;
+            v = v * v * v;
+            double u = uniform();
+            if (u < 1 - 0.0331 * x * x * x * x
+                || log(u) < 0.5 * x * x + d * (1 - v + log(v)))
+                return d * v;
+        }
+    }
+private:
+    quint64 state;
+    bool hasSpare;
+    double spare;
+};
+
+struct Chunk
+{
+    int iterations;
+    quint64 seed;
+};
+
+// lengths and critical counts of one chunk, the counts are kept apart
+// for every chunk and summed when all are done
+struct ChunkResult
+{
+    QVector<double> lengths;
+    QVector<int> critical;
+};
+
+struct ChunkSimulator
+{
+    typedef ChunkResult result_type;
+    const MonteCarloEngine *engine;
+    ChunkSimulator(const MonteCarloEngine *engine) : engine(engine) {}
+    ChunkResult operator()(const Chunk &chunk) const
+    {
+        ChunkResult result;
+        engine->simulate(chunk.iterations, chunk.seed, result.lengths, result.critical);
+        return result;
+    }
+};
+
+}
+
+const int MonteCarloEngine::chunkSize;
+
+MonteCarloEngine::MonteCarloEngine(const CpmEngine &schedule, const QVector<double> &optimistic,
+                                   const QVector<double> &pessimistic, Distribution distribution) :
+        distribution(distribution)
+{
+    const NetSnapshot &net = schedule.snapshot();
+    eventCount = net.eventCount();
+    int m = net.arcCount();
+    arcs.reserve(m);
+    begins.reserve(m);
+    ends.reserve(m);
+    lows.reserve(m);
+    modes.reserve(m);
+    highs.reserve(m);
+    alphas.reserve(m);
+    betas.reserve(m);
+    alphaScales.reserve(m);
+    betaScales.reserve(m);
+    foreach (int i, schedule.order())
+    {
+        for (int l = net.outBegin(i); l < net.outEnd(i); ++l)
+        {
+            int a = net.outArc(l);
+            double mode = net.duration(a);
+            double low = optimistic[a] < mode ? optimistic[a] : mode;
+            double high = pessimistic[a] > mode ? pessimistic[a] : mode;
+            arcs << a;
+            begins << i;
+            ends << net.arcEnd(a);
+            lows << low;
+            modes << mode;
+            highs << high;
+            if (high == low || distribution == Triangular)
+            {
+                alphas << (high > low ? (mode - low) / (high - low) : 0);
+                betas << 0;
+                alphaScales << 0;
+                betaScales << 0;
+            }
+            else
+            {
+                double alpha = 1 + 4 * (mode - low) / (high - low) - 1.0 / 3;
+                double beta = 1 + 4 * (high - mode) / (high - low) - 1.0 / 3;
+                alphas << alpha;
+                betas << beta;
+                alphaScales << 1 / sqrt(9 * alpha);
+                betaScales << 1 / sqrt(9 * beta);
+            }
+        }
+    }
+}
+
+void MonteCarloEngine::simulate(int iterations, quint64 seed, QVector<double> &lengths,
+                                QVector<int> &critical) const
+{
+    Random random(seed);
+    int m = begins.count();
+    const int *begin = begins.constData();
+    const int *end = ends.constData();
+    const double *low = lows.constData();
+    const double *mode = modes.constData();
+    const double *high = highs.constData();
+    const double *alpha = alphas.constData();
+    const double *beta = betas.constData();
+    const double *alphaScale = alphaScales.constData();
+    const double *betaScale = betaScales.constData();
+    QVector<double> durations(m);
+    QVector<double> earlyTimes(eventCount), tailTimes(eventCount);
+    double *duration = durations.data();
+    double *early = earlyTimes.data();
+    double *tail = tailTimes.data();
+    critical.fill(0, m);
+    int *count = critical.data();
+    for (int it = 0; it < iterations; ++it)
+    {
+        for (int a = 0; a < m; ++a)
+        {
+            if (high[a] == low[a])
+                duration[a] = mode[a];
+            else if (distribution == Triangular)
+            {
+                // inverse of the distribution function
+                double u = random.uniform();
+                double span = high[a] - low[a];
+                duration[a] = u < alpha[a]
+                        ? low[a] + sqrt(u * span * (mode[a] - low[a]))
+                        : high[a] - sqrt((1 - u) * span * (high[a] - mode[a]));
+            }
+            else
+            {
+                double x = random.gamma(alpha[a], alphaScale[a]);
+                double y = random.gamma(beta[a], betaScale[a]);
+                duration[a] = low[a] + (high[a] - low[a]) * x / (x + y);
+            }
+        }
+
+        for (int i = 0; i < eventCount; ++i)
+            early[i] = 0;
+        double length = 0;
+        for (int a = 0; a < m; ++a)
+        {
+            double t = early[begin[a]] + duration[a];
+            if (t > early[end[a]])
+                early[end[a]] = t;
+            if (t > length)
+                length = t;
+        }
+        lengths << length;
+
+        // backward pass, an arc is critical when the longest path
+        // through it is as long as the net
+        for (int i = 0; i < eventCount; ++i)
+            tail[i] = 0;
+        for (int a = m - 1; a >= 0; --a)
+        {
+            double t = duration[a] + tail[end[a]];
+            if (t > tail[begin[a]])
+                tail[begin[a]] = t;
+            if (qFuzzyCompare(early[begin[a]] + t + 1.0, length + 1.0))
+                ++count[a];
+        }
+    }
+}
+
+SimulationResult MonteCarloEngine::run(int iterations, quint64 seed) const
+{
+    QList<Chunk> chunks;
+    for (int done = 0; done < iterations; done += chunkSize)
+    {
+        Chunk chunk;
+        chunk.iterations = qMin(chunkSize, iterations - done);
+        chunk.seed = seed * Q_UINT64_C(0x100000000) + chunks.count();
+        chunks << chunk;
+    }
+    QList<ChunkResult> parts =
+            QtConcurrent::blockingMapped< QList<ChunkResult> >(chunks, ChunkSimulator(this));
+
+    SimulationResult result;
+    result.iterations = iterations;
+    result.lengths.reserve(iterations);
+    int m = arcs.count();
+    QVector<int> critical(m, 0);
+    foreach (const ChunkResult &part, parts)
+    {
+        result.lengths += part.lengths;
+        for (int a = 0; a < m; ++a)
+            critical[a] += part.critical[a];
+    }
+    qSort(result.lengths);
+    double sum = 0;
+    foreach (double t, result.lengths)
+        sum += t;
+    if (iterations > 0)
+    {
+        result.mean = sum / iterations;
+        double squares = 0;
+        foreach (double t, result.lengths)
+            squares += (t - result.mean) * (t - result.mean);
+        result.deviation = sqrt(squares / iterations);
+        result.criticality.fill(0, m);
+        for (int a = 0; a < m; ++a)
+            result.criticality[arcs[a]] = (double)critical[a] / iterations;
+    }
+    return result;
+}
@@ -0,0 +1,62 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include "cpmengine.h"
+#include <QVector>
+
+// Completion times of a net over many sampled durations,
+// see MonteCarloEngine.
+struct SimulationResult
+{
+    int iterations;
+    double mean, deviation;
+    // sampled lengths of the net in ascending order
+    QVector<double> lengths;
+    // criticality index of every arc of the snapshot: the share of
+    // iterations in which the arc was on a critical path
+    QVector<double> criticality;
+    SimulationResult() : iterations(0), mean(0), deviation(0) {}
+    // the least length not exceeded in the share p of iterations
+    double percentile(double p) const;
+    // counts of lengths in equal bins from the least to the largest one
+    QVector<int> histogram(int bins) const;
+};
+
+// Monte Carlo simulation of a net with PERT estimates. Every iteration
+// samples all durations between the optimistic and the pessimistic
+// time with the snapshot duration as the mode, and runs the forward
+// pass over the arcs sorted by their begin events. Iterations are split
+// into chunks of a fixed size run in parallel, every chunk has its own
+// random stream derived from the seed, so the result depends on the
+// seed only and not on the number of threads. A backward pass then
+// finds the arcs on critical paths of the iteration.
+class MonteCarloEngine
+{
+public:
+    enum Distribution {Triangular, BetaPert};
+    // the schedule must be acyclic
+    MonteCarloEngine(const CpmEngine &schedule, const QVector<double> &optimistic,
+                     const QVector<double> &pessimistic, Distribution distribution = BetaPert);
+    SimulationResult run(int iterations, quint64 seed = 1) const;
+    static const int chunkSize = 256;
+    // runs iterations of one chunk, appends their lengths and counts
+    // the iterations in which every arc was critical, in the order of
+    // the forward pass
+    void simulate(int iterations, quint64 seed, QVector<double> &lengths,
+                  QVector<int> &critical) const;
+private:
+    Distribution distribution;
+    int eventCount;
+    // arcs in the order of the forward pass, their indices in the
+    // snapshot and events
+    QVector<int> arcs, begins, ends;
+    // lowest, most likely and highest durations, and the parameters of
+    // the distribution: the share of the mode for the triangular one;
+    // for PERT the shape parameters of the beta distribution less 1/3
+    // and 1/sqrt(9 * that), as taken by the gamma sampler
+    QVector<double> lows, modes, highs;
+    QVector<double> alphas, betas;
+    QVector<double> alphaScales, betaScales;
+};
+
+#endif // MONTECARLO_H
@@ -0,0 +1,28 @@
+#ifndef NETDIAGNOSTICS_H
+#define NETDIAGNOSTICS_H
+
+#include "netmodel.h"
+#include <QList>
+
+// Result of checking a net for correctness, one list per rule.
+// Lists are empty when the rule holds.
+struct NetDiagnostics
+{
+    // events of one of the loops in the order of operations
+    QList<Event*> loop;
+    // operations with the same code as an earlier operation
+    QList<Operation*> multiEdges;
+    // events without input and without output operations,
+    // the net is correct when there is exactly one of each
+    QList<Event*> beginEvents, endEvents;
+    QList<Event*> unconnectedEvents;
+    QList<Operation*> unconnectedOperations;
+    bool isCorrect() const
+    {
+        return loop.isEmpty() && multiEdges.isEmpty() && beginEvents.count() == 1
+                && endEvents.count() == 1 && unconnectedEvents.isEmpty()
+                && unconnectedOperations.isEmpty();
+    }
+};
+
+#endif // NETDIAGNOSTICS_H
@@ -0,0 +1,23 @@
+#ifndef NETMETRICS_H
+#define NETMETRICS_H
+
+#include "netmodel.h"
+#include <QVector>
+
+// Calculated parameters of a net, one array per table column.
+// Event rows are sorted by number, operation rows by code.
+struct NetMetrics
+{
+    double length;
+    // events
+    QVector<Event*> events;
+    QVector<double> eventEarly, eventLater, eventReserve;
+    // operations
+    QVector<Operation*> operations;
+    QVector<double> duration;
+    QVector<double> earlyStart, laterStart, earlyEnd, laterEnd;
+    QVector<double> fullReserve, freeReserve, intensity;
+    NetMetrics() : length(0) {}
+};
+
+#endif // NETMETRICS_H
@@ -1,13 +1,26 @@
 #include "netmodel.h"
-#include "cachemanager.h"
+#include "netsnapshot.h"
+#include "cpmengine.h"
+#include "netmetrics.h"
+#include "pertengine.h"
+#include "montecarlo.h"
+#include "crashing.h"
+#include "netdiagnostics.h"
+#include "cpmtask.h"
+#include "scenarioresult.h"
+#include <QThreadPool>
+#include <QtConcurrentMap>
 #include <QDebug>
 #include <limits>
+#include <queue>
+#include <assert.h>
 
 using namespace std;
 
 Event::Event()
 {
     n = 0;
+    order = 0;
     point.setX(0);
     point.setY(0);
 }
@@ -15,6 +28,7 @@ Event::Event()
 Event::Event(int n)
 {
     this->n = n;
+    order = 0;
     point.setX(0);
     point.setY(0);
 }
@@ -29,16 +43,6 @@ void Event::addOutOperation(Operation *operation)
     outputOperations << operation;
 }
 
-bool Event::hasEdge(Event *e)
-{
-    foreach (Operation *o, outputOperations)
-    {
-        if (o->getEndEvent()==e)
-            return true;
-    }
-    return false;
-}
-
 int Event::getN() const
 {
     return n;
@@ -55,12 +59,12 @@ QList<Operation*>& Event::getOutOperations()
 }
 
 Operation::Operation() :
-        beginEvent(NULL), endEvent(NULL), tmin(0), tmax(0), twait(0), _inCriticalPath(false)
+        beginEvent(NULL), endEvent(NULL), tmin(0), tmax(0), twait(0), _inCriticalPath(false), registered(false), pooled(false), inSlot(-1), criticality(-1)
 {
 }
 
 Operation::Operation(double twait) :
-        beginEvent(NULL), endEvent(NULL), tmin(0), tmax(0), twait(twait), _inCriticalPath(false)
+        beginEvent(NULL), endEvent(NULL), tmin(twait), tmax(twait), twait(twait), _inCriticalPath(false), registered(false), pooled(false), inSlot(-1), criticality(-1)
 {
 }
 
@@ -103,6 +107,13 @@ Path::Path(QList<Event*> events)
     _code = calcCode();
 }
 
+Path::Path(const QList<Event*> &events, double weight)
+{
+    this->events = events;
+    _weight = weight;
+    _code = calcCode();
+}
+
 QString Path::calcCode() const
 {
     QString s;
@@ -137,29 +148,184 @@ double Path::calcWeight() const
     return weight;
 }
 
-NetModel::NetModel() : fullPathes(NULL), criticPathes(NULL)
+NetModel::NetModel() : fullPathes(NULL), criticPathes(NULL), schedule(NULL), metrics(NULL),
+    diagnostics(NULL), unconnected(0), orderValid(true), nextOrder(0),
+    duplicates(0), transactions(0), pending(false), async(false), version(0),
+    analysisVersion(-1), pert(NULL), simulated(false)
 {
     QObject::connect(this, SIGNAL(updated()), this, SLOT(updateCriticalPath()));
-    cmanager = new CacheManager();
+    qRegisterMetaType<CpmResult>("CpmResult");
+}
+
+// Changes made between beginTransaction() and the matching commit()
+// are announced by one updated() at commit, so views and the critical
+// path are refreshed once. Transactions may be nested.
+void NetModel::beginTransaction()
+{
+    ++transactions;
+}
+
+void NetModel::commit()
+{
+    if (transactions>0 && --transactions==0 && pending)
+    {
+        pending = false;
+        flush();
+    }
+}
+
+void NetModel::notify()
+{
+    if (transactions)
+        pending = true;
+    else
+        flush();
+}
+
+// The critical path is recalculated on updated(), so the delta
+// is complete only after it.
+void NetModel::flush()
+{
+    emit updated();
+    // in the background the changes are announced with the schedule
+    if (analysisVersion==-1)
+        emitDelta();
+}
+
+void NetModel::emitDelta()
+{
+    ModelDelta changes = delta;
+    delta.clear();
+    // views rely on no item being both added and removed
+    foreach (Event *e, changes.addedEvents)
+        assert(!changes.removedEvents.contains(e));
+    foreach (Operation *o, changes.addedOperations)
+        assert(!changes.removedOperations.contains(o));
+    emit modelChanged(changes);
+}
+
+void NetModel::setAsync(bool async)
+{
+    this->async = async;
+    if (!async && analysisVersion!=-1)
+    {
+        analysisVersion = -1;
+        markCriticalPath();
+        emitDelta();
+    }
+}
+
+// The snapshot is taken here, the schedule is calculated by a task
+// in the thread pool and comes back through the event loop.
+void NetModel::startAnalysis()
+{
+    CpmTask *task = new CpmTask(NetSnapshot(events, operations), version);
+    QObject::connect(task, SIGNAL(finished(const CpmResult &)),
+                     this, SLOT(analysisFinished(const CpmResult &)), Qt::QueuedConnection);
+    analysisVersion = version;
+    QThreadPool::globalInstance()->start(task);
+}
+
+void NetModel::analysisFinished(const CpmResult &result)
+{
+    // a newer analysis is running or the result is not awaited
+    if (result.version!=analysisVersion)
+        return;
+    analysisVersion = -1;
+    // changed within a transaction, analysed again at commit
+    if (result.version!=version)
+        return;
+    if (!schedule)
+    {
+        schedule = new CpmEngine(result.schedule);
+        intensities = result.intensity;
+    }
+    markCriticalPath();
+    emitDelta();
 }
 
 void NetModel::updateCriticalPath()
 {
     clearCache();
+    if (async && !schedule)
+    {
+        if (analysisVersion!=version)
+            startAnalysis();
+        return;
+    }
+    markCriticalPath();
+}
+
+void NetModel::markCriticalPath()
+{
+    bool correct = isCorrect();
+    CpmEngine *cpm = getSchedule();
+    const NetSnapshot &net = cpm->snapshot();
     foreach (Operation *o, operations)
     {
-        o->_inCriticalPath = inCriticalPath(o);
+        int a = net.indexOf(o);
+        bool critical = correct && a != -1 && cpm->isCritical(a);
+        if (critical!=o->_inCriticalPath)
+            delta.criticalityChanged.insert(o);
+        o->_inCriticalPath = critical;
     }
 }
 
 NetModel::~NetModel()
 {
     clearCache();
-    qDeleteAll(events);
+    invalidate();
+    destroyAll();
+}
+
+Event *NetModel::createEvent(int n)
+{
+    return new (eventPool.allocate()) Event(n);
+}
+
+void NetModel::destroyEvent(Event *e)
+{
+    e->~Event();
+    eventPool.free(e);
+}
+
+// Operations for the model must be created here. Operations
+// created by new are still accepted and deleted.
+Operation *NetModel::createOperation(double twait)
+{
+    Operation *o = new (operationPool.allocate()) Operation(twait);
+    o->pooled = true;
+    return o;
+}
+
+// Destroys an operation that has not been added to the model.
+void NetModel::destroyOperation(Operation *o)
+{
+    if (o->pooled)
+    {
+        o->~Operation();
+        operationPool.free(o);
+    }
+    else
+        delete o;
+}
+
+// Runs the destructors and then gives the slabs back at once.
+void NetModel::destroyAll()
+{
+    foreach (Event *e, events)
+        e->~Event();
     events.clear();
-    qDeleteAll(operations);
+    foreach (Operation *o, operations)
+    {
+        if (o->pooled)
+            o->~Operation();
+        else
+            delete o;
+    }
     operations.clear();
-    delete cmanager;
+    eventPool.release();
+    operationPool.release();
 }
 
 void NetModel::clearCache()
@@ -174,21 +340,48 @@ void NetModel::clearCache()
         delete criticPathes;
         criticPathes = NULL;
     }
-    cmanager->reset(0);
+    if (metrics)
+    {
+        delete metrics;
+        metrics = NULL;
+    }
 }
 
-Event* NetModel::getEventByNumber(int n)
+// Must be called on every structural change: the snapshot holds
+// pointers to events and operations.
+void NetModel::invalidate()
 {
-    foreach(Event *event, events)
+    delta.structureChanged = true;
+    ++version;
+    intensities.clear();
+    dropSimulation();
+    if (pert)
     {
-        if (event->getN()==n)
-            return event;
+        delete pert;
+        pert = NULL;
+    }
+    if (schedule)
+    {
+        delete schedule;
+        schedule = NULL;
+    }
+    if (diagnostics)
+    {
+        delete diagnostics;
+        diagnostics = NULL;
     }
-    return NULL;
 }
 
+Event* NetModel::getEventByNumber(int n)
+{
+    return eventsByNumber.value(n, NULL);
+}
+
+// Operations with unconnected ends are not indexed.
 Operation* NetModel::getOperationByEvents(Event* beginEvent, Event* endEvent)
 {
+    if (beginEvent && endEvent)
+        return operationsByEvents.value(qMakePair(beginEvent, endEvent), NULL);
     foreach(Operation *operation, operations)
     {
         if (operation->getBeginEvent()==beginEvent && operation->getEndEvent()==endEvent)
@@ -197,15 +390,59 @@ Operation* NetModel::getOperationByEvents(Event* beginEvent, Event* endEvent)
     return NULL;
 }
 
+void NetModel::indexOperation(Operation *o)
+{
+    if (!o->registered || !o->getBeginEvent() || !o->getEndEvent())
+        return;
+    QPair<Event*, Event*> key = qMakePair(o->getBeginEvent(), o->getEndEvent());
+    if (operationsByEvents.contains(key))
+        ++duplicates;
+    else
+        operationsByEvents.insert(key, o);
+}
+
+// Must be called before an end of the operation is disconnected.
+void NetModel::unindexOperation(Operation *o)
+{
+    if (!o->registered || !o->getBeginEvent() || !o->getEndEvent())
+        return;
+    QPair<Event*, Event*> key = qMakePair(o->getBeginEvent(), o->getEndEvent());
+    if (operationsByEvents.value(key)!=o)
+    {
+        --duplicates;
+        return;
+    }
+    operationsByEvents.remove(key);
+    if (duplicates)
+    {
+        foreach (Operation *operation, operations)
+        {
+            if (operation!=o && operation->registered && operation->getBeginEvent()==key.first
+                && operation->getEndEvent()==key.second)
+            {
+                operationsByEvents.insert(key, operation);
+                --duplicates;
+                break;
+            }
+        }
+    }
+}
+
 bool NetModel::add(Operation* operation)
 {
     if (operation)
     {
-        if (operations.indexOf(operation)==-1)
+        if (!operation->registered)
         {
             if (operation->getBeginEvent()&&operation->getEndEvent()&&getOperationByEvents(operation->getBeginEvent(), operation->getEndEvent()))
                 return false;
             operations << operation;
+            operation->registered = true;
+            if (isUnconnected(operation))
+                ++unconnected;
+            indexOperation(operation);
+            delta.operationAdded(operation);
+            invalidate();
             return true;
         }
         else
@@ -215,18 +452,27 @@ bool NetModel::add(Operation* operation)
         return false;
 }
 
+// Membership is known from the flag, the list is only compacted.
 bool NetModel::remove(Operation* operation)
 {
-    int index=operations.indexOf(operation);
-    if (index!=-1)
-    {
-        disconnect(operation->getBeginEvent(), operation);
-        disconnect(operation, operation->getEndEvent());
-        operations.removeAt(index);
-        delete operation;
-        return true;
-    }
-    return false;
+    if (!operation || !operation->registered)
+        return false;
+    operations.removeOne(operation);
+    release(operation);
+    return true;
+}
+
+// Disconnects and destroys an operation already taken out of the list.
+void NetModel::release(Operation *operation)
+{
+    disconnect(operation->getBeginEvent(), operation);
+    disconnect(operation, operation->getEndEvent());
+    if (isUnconnected(operation))
+        --unconnected;
+    operation->registered = false;
+    invalidate();
+    delta.operationRemoved(operation);
+    destroyOperation(operation);
 }
 
 bool NetModel::add(Event* event)
@@ -235,16 +481,17 @@ bool NetModel::add(Event* event)
     {
         if (event->getN()<0)
             return false;
-        foreach (Event *e, events)
-            if (e->getN()==event->getN())
-                return false;
-        if (events.indexOf(event)==-1)
-        {
-            events << event;
-            return true;
-        }
-        else
-           return false;
+        // an event of the model is indexed by its number
+        if (eventsByNumber.contains(event->getN()))
+            return false;
+        events << event;
+        eventsByNumber.insert(event->getN(), event);
+        ids.use(event->getN());
+        delta.eventAdded(event);
+        event->order = nextOrder++;
+        updateDegree(event);
+        invalidate();
+        return true;
     }
     else
         return false;
@@ -256,39 +503,54 @@ bool NetModel::insert(int i, Event* event)
     {
         if (event->getN()<0)
             return false;
-        foreach (Event *e, events)
-            if (e->getN()==event->getN())
-                return false;
-        if (events.indexOf(event)==-1)
-        {
-            events.insert(i, event);
-            return true;
-        }
-        else
+        if (eventsByNumber.contains(event->getN()))
             return false;
+        events.insert(i, event);
+        eventsByNumber.insert(event->getN(), event);
+        ids.use(event->getN());
+        delta.eventAdded(event);
+        event->order = nextOrder++;
+        updateDegree(event);
+        invalidate();
+        return true;
     }
     else
         return false;
 }
 
+// Membership is known from the index by number, the list is only
+// compacted.
 bool NetModel::remove(Event* event)
 {
-    int index=events.indexOf(event);
-    if (index!=-1)
-    {
-        QList<Operation*> in = event->getInOperations();
-        foreach (Operation *o, in)
-            disconnect(o, event);
-        event->getInOperations().clear();
-        QList<Operation*> out = event->getOutOperations();
-        foreach (Operation *o, out)
-            disconnect(event, o);
-        event->getOutOperations().clear();
-        events.removeAt(index);
-        delete event;
-        return true;
+    if (!event || eventsByNumber.value(event->getN())!=event)
+        return false;
+    events.removeOne(event);
+    release(event);
+    return true;
+}
+
+// Disconnects and destroys an event already taken out of the list.
+void NetModel::release(Event *event)
+{
+    QList<Operation*> in = event->getInOperations();
+    foreach (Operation *o, in)
+        disconnect(o, event);
+    event->getInOperations().clear();
+    QList<Operation*> out = event->getOutOperations();
+    event->getOutOperations().clear();
+    foreach (Operation *o, out)
+    {
+        if (o->getBeginEvent()==event)
+            clearBeginEvent(o);
     }
-    return false;
+    eventsByNumber.remove(event->getN());
+    ids.release(event->getN());
+    sources.remove(event);
+    sinks.remove(event);
+    isolated.remove(event);
+    invalidate();
+    delta.eventRemoved(event);
+    destroyEvent(event);
 }
 
 void NetModel::connect(Event* event, Operation* operation)
@@ -296,7 +558,16 @@ void NetModel::connect(Event* event, Operation* operation)
     if (operation && operation->getBeginEvent()==NULL)
     {
         if (event) event->addOutOperation(operation);
+        if (isUnconnected(operation))
+            --unconnected;
         operation->setBeginEvent(event);
+        if (isUnconnected(operation))
+            ++unconnected;
+        indexOperation(operation);
+        updateDegree(event);
+        if (event && operation->getEndEvent())
+            addArc(event, operation->getEndEvent());
+        invalidate();
     }
 }
 
@@ -304,8 +575,21 @@ void NetModel::connect(Operation* operation, Event* event)
 {
     if (operation && operation->getEndEvent()==NULL)
     {
-        if (event) event->addInOperation(operation);
+        if (event)
+        {
+            operation->inSlot = event->getInOperations().count();
+            event->addInOperation(operation);
+        }
+        if (isUnconnected(operation))
+            --unconnected;
         operation->setEndEvent(event);
+        if (isUnconnected(operation))
+            ++unconnected;
+        indexOperation(operation);
+        updateDegree(event);
+        if (event && operation->getBeginEvent())
+            addArc(operation->getBeginEvent(), event);
+        invalidate();
     }
 }
 
@@ -316,179 +600,342 @@ void NetModel::disconnect(Event* event,Operation* operation)
         int index=event->getOutOperations().indexOf(operation);
         if (index!=-1)
             event->getOutOperations().removeAt(index);
+        updateDegree(event);
     }
     if (operation && operation->getBeginEvent()==event)
-        operation->setBeginEvent(NULL);
+        clearBeginEvent(operation);
+    invalidate();
+}
+
+// Detaches the operation from its begin event, the event must
+// already have dropped it from its output operations.
+void NetModel::clearBeginEvent(Operation *operation)
+{
+    unindexOperation(operation);
+    if (isUnconnected(operation))
+        --unconnected;
+    operation->setBeginEvent(NULL);
+    if (isUnconnected(operation))
+        ++unconnected;
 }
 
 void NetModel::disconnect(Operation* operation,Event* event)
 {
     if (event)
     {
-        int index=event->getInOperations().indexOf(operation);
+        // the order of input operations does not matter, so the last
+        // one takes the place of the removed one
+        QList<Operation*> &in = event->getInOperations();
+        int index=-1;
+        if (operation && operation->inSlot>=0 && operation->inSlot<in.count()
+            && in[operation->inSlot]==operation)
+            index = operation->inSlot;
+        else
+            index = in.indexOf(operation);
         if (index!=-1)
-            event->getInOperations().removeAt(index);
+        {
+            in[index] = in.last();
+            in[index]->inSlot = index;
+            in.removeLast();
+        }
+        updateDegree(event);
     }
     if (operation && operation->getEndEvent()==event)
+    {
+        unindexOperation(operation);
+        if (isUnconnected(operation))
+            --unconnected;
         operation->setEndEvent(NULL);
+        if (isUnconnected(operation))
+            ++unconnected;
+    }
+    invalidate();
 }
 
-void NetModel::connect(Event *e1, Operation *o, Event *e2)
+// Keeps the sets of begin, end and unconnected events up to date,
+// must be called whenever the operations of an event change.
+void NetModel::updateDegree(Event *e)
 {
-    connect(e1,o);
-    connect(o,e2);
+    if (!e)
+        return;
+    bool noInput = e->getInOperations().isEmpty();
+    bool noOutput = e->getOutOperations().isEmpty();
+    if (noInput)
+        sources.insert(e);
+    else
+        sources.remove(e);
+    if (noOutput)
+        sinks.insert(e);
+    else
+        sinks.remove(e);
+    if (noInput && noOutput)
+        isolated.insert(e);
+    else
+        isolated.remove(e);
 }
 
-#define A(i, j) a[i * n + j]
-
-bool NetModel::hasLoops()
+// Pearce-Kelly: when the arc x->y goes against the order, only the
+// events ordered between y and x are affected. The events reachable
+// from y and the events reaching x among them swap their positions,
+// keeping the relative order within each group.
+void NetModel::addArc(Event *x, Event *y)
 {
-    int n = events.count();
-    bool *a = new bool[n * n];
-    for (int i = 0; i < n; ++i)
+    if (!orderValid || x->order < y->order)
+        return;
+    QMap<int, Event*> forward, backward;
+    if (x==y || reaches(y, x, x->order, &forward))
     {
-        for (int j = 0; j < n; ++j)
-        {
-            A(i, j) = events[i]->hasEdge(events[j]);
-        }
+        orderValid = false;
+        return;
     }
-
-    for (int i = 0; i < n; ++i)
+    QList<Event*> stack;
+    stack << x;
+    backward.insert(x->order, x);
+    while (!stack.isEmpty())
     {
-        for (int j = 0; j < n; ++j)
+        Event *e = stack.takeLast();
+        foreach (Operation *o, e->getInOperations())
         {
-            for (int k = 0; k < n; ++k)
+            Event *w = o->getBeginEvent();
+            if (w && w->order > y->order && !backward.contains(w->order))
             {
-                A(j, k) = A(j, k) || (A(j, i) && A(i, k));
+                backward.insert(w->order, w);
+                stack << w;
             }
         }
     }
-    for (int i = 0; i < n; ++i)
+    QList<int> pool = backward.keys() + forward.keys();
+    qSort(pool);
+    int k = 0;
+    foreach (Event *e, backward)
+        e->order = pool[k++];
+    foreach (Event *e, forward)
+        e->order = pool[k++];
+}
+
+// Depth-first search for a path from one event to another over the
+// events ordered before bound, the visited events are put to region.
+bool NetModel::reaches(Event *from, Event *to, int bound, QMap<int, Event*> *region)
+{
+    QList<Event*> stack;
+    stack << from;
+    region->insert(from->order, from);
+    while (!stack.isEmpty())
     {
-        if (A(i, i))
+        Event *e = stack.takeLast();
+        foreach (Operation *o, e->getOutOperations())
         {
-            delete[] a;
-            return true;
+            Event *w = o->getEndEvent();
+            if (w==to)
+                return true;
+            if (w && w->order < bound && !region->contains(w->order))
+            {
+                region->insert(w->order, w);
+                stack << w;
+            }
         }
     }
-
-    delete[] a;
     return false;
 }
 
-bool NetModel::hasMultiEdges()
+// Kahn's algorithm over the operations of events, used after
+// the loops that made the order invalid have been removed.
+void NetModel::rebuildOrder()
 {
+    QHash<Event*, int> indegree;
+    QList<Event*> order;
     foreach (Event *e, events)
     {
-        QList<Operation*> operations = e->getOutOperations();
-        for (int i=0;i<operations.count();++i)
+        int count = 0;
+        foreach (Operation *o, e->getInOperations())
         {
-            int multi=0;
-            Event *endEvent=operations[i]->getEndEvent();
-            for (int j=i+1;j<operations.count();++j)
-            {
-                multi += (endEvent==operations[j]->getEndEvent()?1:0);
-            }
-            if (multi)
-                return true;
+            if (o->getBeginEvent())
+                ++count;
         }
+        indegree.insert(e, count);
+        if (count==0)
+            order << e;
+    }
+    for (int k = 0; k < order.count(); ++k)
+    {
+        foreach (Operation *o, order[k]->getOutOperations())
+        {
+            Event *w = o->getEndEvent();
+            if (w && --indegree[w]==0)
+                order << w;
+        }
+    }
+    orderValid = order.count()==events.count();
+    if (orderValid)
+    {
+        for (int k = 0; k < order.count(); ++k)
+            order[k]->order = k;
+        nextOrder = order.count();
     }
-    return false;
 }
 
-bool NetModel::hasOneBeginEvent()
+// Whether an operation from one event to another would make a loop.
+// Only the events ordered between them are searched.
+bool NetModel::createsLoop(Event *from, Event *to)
 {
-    int count=0;
-    foreach (Event *event, events)
-    {
-        if (event->getInOperations().count()==0)
-            ++count;
-    }
-    if (count==1)
+    if (!from || !to)
+        return false;
+    if (from==to)
         return true;
+    if (!orderValid)
+        rebuildOrder();
+    QMap<int, Event*> region;
+    if (orderValid)
+        return from->order > to->order && reaches(to, from, from->order, &region);
     else
-        return false;
+        return reaches(to, from, numeric_limits<int>::max(), &region);
+}
+
+void NetModel::connect(Event *e1, Operation *o, Event *e2)
+{
+    connect(e1,o);
+    connect(o,e2);
+}
+
+// The online order is valid as long as there are no loops, it is
+// built anew only after a loop has been made.
+bool NetModel::hasLoops()
+{
+    if (!orderValid)
+        rebuildOrder();
+    return !orderValid;
+}
+
+// Events of one of the loops in the order of operations,
+// empty if there are no loops.
+QList<Event*> NetModel::getLoop()
+{
+    return getDiagnostics()->loop;
+}
+
+bool NetModel::hasMultiEdges()
+{
+    return !getDiagnostics()->multiEdges.isEmpty();
+}
+
+bool NetModel::hasOneBeginEvent()
+{
+    return sources.count()==1;
 }
 
 bool NetModel::hasOneEndEvent()
 {
-    int count=0;
-    foreach (Event *event, events)
-    {
-        if (event->getOutOperations().count()==0)
-            ++count;
-    }
-    if (count==1)
-        return true;
-    else
-        return false;
+    return sinks.count()==1;
 }
 
 bool NetModel::hasUnconnectedEvents()
 {
-    foreach (Event *e, events)
-    {
-        if (e->getInOperations().count()==0&&e->getOutOperations().count()==0)
-            return true;
-    }
-    return false;
+    return !isolated.isEmpty();
 }
 
 bool NetModel::hasUnconnectedOperations()
 {
-    foreach (Operation *o, operations)
-    {
-        if (o->getBeginEvent()==NULL||o->getEndEvent()==NULL)
-            return true;
-    }
-    return false;
+    return unconnected!=0;
 }
 
+// Every rule is kept by counters and sets, so a correct net is
+// recognized without the schedule.
 bool NetModel::isCorrect()
 {
-    return (!hasLoops() && !hasMultiEdges() && hasOneBeginEvent() && hasOneEndEvent()
-            && !hasUnconnectedEvents() && !hasUnconnectedOperations());
+    if (sources.count()!=1 || sinks.count()!=1 || !isolated.isEmpty()
+        || duplicates || unconnected)
+        return false;
+    return !hasLoops();
+}
+
+static QString eventsCode(const QList<Event*> &events)
+{
+    QString code;
+    foreach (Event *e, events)
+        code += e->formatted();
+    return code.isEmpty() ? code : ":" + code;
+}
+
+static QString operationsCode(const QList<Operation*> &operations)
+{
+    QString code;
+    foreach (Operation *o, operations)
+        code += " (" + o->getCode() + ")";
+    return code.isEmpty() ? code : ":" + code;
 }
 
 bool NetModel::isCorrect(QString &s)
 {
+    const NetDiagnostics *d = getDiagnostics();
     s = "";
-    bool isCorrect = true;
-    if (hasLoops())
+    if (!d->loop.isEmpty())
     {
-        s += "Имеются циклы\n";
-        isCorrect = false;
+        QString code;
+        foreach (Event *e, d->loop)
+            code += e->formatted() + Event::divider();
+        code += d->loop.first()->formatted();
+        s += "Имеются циклы:" + code + "\n";
     }
-    if (hasMultiEdges())
+    if (!d->multiEdges.isEmpty())
+        s += "Имеются работы с одинаковыми кодами" + operationsCode(d->multiEdges) + "\n";
+    if (d->beginEvents.count()!=1)
+        s += "Исходное событие не определено" + eventsCode(d->beginEvents) + "\n";
+    if (d->endEvents.count()!=1)
+        s += "Завершающее событие не определено" + eventsCode(d->endEvents) + "\n";
+    if (!d->unconnectedEvents.isEmpty())
+        s += "Некоторые события не соединены с работами" + eventsCode(d->unconnectedEvents) + "\n";
+    if (!d->unconnectedOperations.isEmpty())
+        s += "Некоторые работы не соединены с событиями" + operationsCode(d->unconnectedOperations) + "\n";
+    if (!d->isCorrect())
     {
-        s += "Имеются работы с одинаковыми кодами\n";
-        isCorrect = false;
-    }
-    if (!hasOneBeginEvent())
-    {
-        s += "Исходное событие не определено\n";
-        isCorrect = false;
-    }
-    if (!hasOneEndEvent())
-    {
-        s += "Завершающее событие не определено\n";
-        isCorrect = false;
-    }
-    if (hasUnconnectedEvents())
-    {
-        s += "Некоторые события не соединены с работами\n";
-        isCorrect = false;
+        s += "Сетевая модель некорректна\n";
     }
-    if (hasUnconnectedOperations())
+    return d->isCorrect();
+}
+
+// The diagnostics depend on the structure only, so they are kept
+// until the next structural change.
+const NetDiagnostics *NetModel::getDiagnostics()
+{
+    if (!diagnostics)
+        diagnostics = calcDiagnostics();
+    return diagnostics;
+}
+
+// All rules are checked in one pass over events and operations,
+// loops are taken from the topological order of the schedule.
+NetDiagnostics *NetModel::calcDiagnostics()
+{
+    NetDiagnostics *d = new NetDiagnostics();
+    CpmEngine *cpm = getSchedule();
+    foreach (int i, cpm->loop())
+        d->loop << cpm->snapshot().event(i);
+    QSet<Event*> endEvents;
+    foreach (Event *e, events)
     {
-        s += "Некоторые работы не соединены с событиями\n";
-        isCorrect = false;
+        bool noInput = e->getInOperations().isEmpty();
+        bool noOutput = e->getOutOperations().isEmpty();
+        if (noInput)
+            d->beginEvents << e;
+        if (noOutput)
+            d->endEvents << e;
+        if (noInput && noOutput)
+            d->unconnectedEvents << e;
+        endEvents.clear();
+        foreach (Operation *o, e->getOutOperations())
+        {
+            if (endEvents.contains(o->getEndEvent()))
+                d->multiEdges << o;
+            else
+                endEvents.insert(o->getEndEvent());
+        }
     }
-    if (!isCorrect)
+    foreach (Operation *o, operations)
     {
-        s += "Сетевая модель некорректна\n";
+        if (o->getBeginEvent()==NULL||o->getEndEvent()==NULL)
+            d->unconnectedOperations << o;
     }
-    return isCorrect;
+    return d;
 }
 
 QString NetModel::print()
@@ -518,52 +965,177 @@ QString NetModel::print()
     return s;
 }
 
-void NetModel::getPathes(Event *begin, Event *end, QList<Path> *pathes)
+class PathCollector : public PathVisitor
 {
-    if (cmanager->get(begin,end,pathes)) return;
-    int ac1=pathes->count();
-    foreach(Operation *operation, end->getInOperations())
+public:
+    PathCollector(QList<Path> *pathes) : pathes(pathes) {}
+    bool visit(const Path &path)
     {
-        if (operation->getBeginEvent()==begin) {
+        pathes->append(path);
+        return true;
+    }
+private:
+    QList<Path> *pathes;
+};
+
+static bool weightLessThan(double w1, double w2)
+{
+    return w1 < w2 && !qFuzzyCompare(w1 + 1.0, w2 + 1.0);
+}
+
+// Depth-first search from the begin to the end event over the snapshot,
+// only the current path is kept in memory. Branches that can not reach
+// minWeight are cut off using the longest path to the end event.
+// Returns the number of visited paths.
+int NetModel::enumeratePathes(PathVisitor *visitor, int maxCount, double minWeight,
+                              const QAtomicInt *cancel)
+{
+    Event *begin = NULL, *end = NULL;
+    getBeginEndEvents(&begin, &end);
+    CpmEngine *cpm = getSchedule();
+    const NetSnapshot &net = cpm->snapshot();
+    int first = net.indexOf(begin);
+    int last = net.indexOf(end);
+    if (first == -1 || last == -1 || first == last || !cpm->isAcyclic() || maxCount == 0)
+        return 0;
+
+    QVector<int> path, next;
+    QVector<double> weight;
+    path << first;
+    next << net.outBegin(first);
+    weight << 0;
+    int count = 0;
+    while (!path.isEmpty())
+    {
+        if (cancel && *cancel)
+            break;
+        int i = path.last();
+        if (next.last() == net.outEnd(i))
+        {
+            path.pop_back();
+            next.pop_back();
+            weight.pop_back();
+            continue;
+        }
+        int a = net.outArc(next.last()++);
+        int j = net.arcEnd(a);
+        double w = weight.last() + net.duration(a);
+        if (weightLessThan(w + cpm->tailTime(j), minWeight))
+            continue;
+        if (j == last)
+        {
             QList<Event*> events;
-            events << begin << end;
-            Path path(events);
-            pathes->append(path);
-        } else {
-            Event *prev = operation->getBeginEvent();
-            int c1 = pathes->count();
-            getPathes(begin, prev, pathes);
-            int c2 = pathes->count();
-            for(int i=c1;i<c2;++i)
-            {
-                (*pathes)[i].append(end);
-            }
+            foreach (int k, path)
+                events << net.event(k);
+            events << net.event(j);
+            ++count;
+            if (!visitor->visit(Path(events, w)) || count == maxCount)
+                break;
+        }
+        else
+        {
+            path << j;
+            next << net.outBegin(j);
+            weight << w;
+        }
+    }
+    return count;
+}
+
+// Number of paths from the begin to the end event, counted in
+// topological order without enumeration. Saturates at the maximum
+// of quint64 instead of overflowing.
+quint64 NetModel::countPathes()
+{
+    Event *begin = NULL, *end = NULL;
+    getBeginEndEvents(&begin, &end);
+    CpmEngine *cpm = getSchedule();
+    const NetSnapshot &net = cpm->snapshot();
+    int first = net.indexOf(begin);
+    int last = net.indexOf(end);
+    if (first == -1 || last == -1 || first == last || !cpm->isAcyclic())
+        return 0;
+
+    const quint64 max = numeric_limits<quint64>::max();
+    QVector<quint64> count(net.eventCount(), 0);
+    count[first] = 1;
+    foreach (int i, cpm->order())
+    {
+        if (count[i] == 0)
+            continue;
+        for (int l = net.outBegin(i); l < net.outEnd(i); ++l)
+        {
+            int j = net.arcEnd(net.outArc(l));
+            count[j] = count[j] > max - count[i] ? max : count[j] + count[i];
         }
     }
-    int ac2=pathes->count();
-    cmanager->put(begin,end,pathes->mid(ac1,ac2-ac1));
+    return count[last];
 }
 
-QList<Path> *NetModel::getMaxPathes(Event *begin, Event *end)
+struct PathNode
+{
+    int event;
+    int parent;
+    double weight;
+};
+
+struct PathCandidate
+{
+    double bound;
+    int order;
+    int node;
+    // of equal bounds the newest node goes first, so a path is followed
+    // to the end before its equal siblings are expanded
+    bool operator<(const PathCandidate &c) const
+    {
+        return bound < c.bound || (bound == c.bound && order < c.order);
+    }
+};
+
+// Best-first search over partial paths from the begin event. A partial
+// path is ranked by its weight plus the longest way to the end event,
+// which is an exact bound, so complete paths come out of the queue in
+// descending weight order and the work grows with k and the path
+// length, not with the total number of paths.
+QList<Path> NetModel::getLongestPathes(int k)
 {
-    QList<Path> *pathes = new QList<Path>;
-    if (begin!=NULL&&end!=NULL&&begin!=end)
+    QList<Path> pathes;
+    Event *begin = NULL, *end = NULL;
+    getBeginEndEvents(&begin, &end);
+    CpmEngine *cpm = getSchedule();
+    const NetSnapshot &net = cpm->snapshot();
+    int first = net.indexOf(begin);
+    int last = net.indexOf(end);
+    if (first == -1 || last == -1 || first == last || !cpm->isAcyclic() || k <= 0)
+        return pathes;
+
+    QVector<PathNode> nodes;
+    priority_queue<PathCandidate> queue;
+    PathNode root = {first, -1, 0};
+    nodes << root;
+    PathCandidate start = {cpm->tailTime(first), 0, 0};
+    queue.push(start);
+    while (!queue.empty() && pathes.count() < k)
     {
-        getPathes(begin,end,pathes);
-        double maxweight=0;
-        foreach (Path p, *pathes)
+        int n = queue.top().node;
+        queue.pop();
+        int i = nodes[n].event;
+        if (i == last)
         {
-            double cur = p.weight();
-            if (cur>maxweight)
-                maxweight=cur;
+            QList<Event*> events;
+            for (int p = n; p != -1; p = nodes[p].parent)
+                events.prepend(net.event(nodes[p].event));
+            pathes << Path(events, nodes[n].weight);
+            continue;
         }
-        QList<Path> copy = *pathes;
-        foreach (Path p, copy)
+        for (int l = net.outBegin(i); l < net.outEnd(i); ++l)
         {
-            if (!qFuzzyCompare(p.weight()+1.0,maxweight+1.0))
-            {
-                pathes->removeAll(p);
-            }
+            int a = net.outArc(l);
+            int j = net.arcEnd(a);
+            PathNode node = {j, n, nodes[n].weight + net.duration(a)};
+            PathCandidate candidate = {node.weight + cpm->tailTime(j), nodes.count(), nodes.count()};
+            nodes << node;
+            queue.push(candidate);
         }
     }
     return pathes;
@@ -618,13 +1190,19 @@ bool eventLessThan(const Event *e1, const Event *e2)
     return e1->getN()<e2->getN();
 }
 
+// an operation without an event goes before the connected ones
+static int eventNumber(const Event *e)
+{
+    return e ? e->getN() : -1;
+}
+
 bool operationLessThan(const Operation *o1, const Operation *o2)
 {
-    if (o1->getBeginEvent()->getN()<o2->getBeginEvent()->getN())
+    if (eventNumber(o1->getBeginEvent())<eventNumber(o2->getBeginEvent()))
         return true;
-    else if (o1->getBeginEvent()->getN()>o2->getBeginEvent()->getN())
+    else if (eventNumber(o1->getBeginEvent())>eventNumber(o2->getBeginEvent()))
         return false;
-    else if (o1->getEndEvent()->getN()<o2->getEndEvent()->getN())
+    else if (eventNumber(o1->getEndEvent())<eventNumber(o2->getEndEvent()))
         return true;
     else
         return false;
@@ -644,18 +1222,19 @@ QList<Operation*> *NetModel::getSortedOperatioins()
     return list;
 }
 
-double NetModel::getMaxPathWeight(Event *begin, Event *end)
-{
-    double w = 0;
-    QList<Path> *pathes = getMaxPathes(begin, end);
-    if (pathes->count()>0)
-        w = pathes->first().weight();
-    delete pathes;
-    return w;
-}
-
+// The begin event is the last event without input operations, the end
+// event is the last one without output operations among the others.
+// Events are only scanned when there are several candidates.
 void NetModel::getBeginEndEvents(Event**begin,Event**end)
 {
+    if (sources.count()<=1 && sinks.count()<=1)
+    {
+        if (sources.count()==1)
+            *begin = *sources.begin();
+        if (sinks.count()==1 && !sources.contains(*sinks.begin()))
+            *end = *sinks.begin();
+        return;
+    }
     foreach (Event *e, events)
     {
         if (e->getInOperations().count()==0)
@@ -667,6 +1246,8 @@ void NetModel::getBeginEndEvents(Event**begin,Event**end)
 
 Event *NetModel::getBeginEvent()
 {
+    if (sources.count()<=1)
+        return sources.isEmpty() ? NULL : *sources.begin();
     Event *begin=NULL;
     foreach (Event *e, events)
     {
@@ -678,6 +1259,8 @@ Event *NetModel::getBeginEvent()
 
 Event *NetModel::getEndEvent()
 {
+    if (sinks.count()<=1)
+        return sinks.isEmpty() ? NULL : *sinks.begin();
     Event *end=NULL;
     foreach (Event *e, events)
     {
@@ -689,17 +1272,17 @@ Event *NetModel::getEndEvent()
 
 QList<Path> *NetModel::_getCriticalPathes()
 {
-    Event *begin, *end;
-    getBeginEndEvents(&begin,&end);
-    return getMaxPathes(begin,end);
+    QList<Path> *pathes = new QList<Path>();
+    PathCollector collector(pathes);
+    enumeratePathes(&collector, -1, getCriticalPathWeight());
+    return pathes;
 }
 
 QList<Path> *NetModel::_getFullPathes()
 {
-    Event *begin, *end;
-    getBeginEndEvents(&begin,&end);
     QList<Path> *pathes = new QList<Path>();
-    getPathes(begin,end,pathes);
+    PathCollector collector(pathes);
+    enumeratePathes(&collector);
     return pathes;
 }
 
@@ -720,23 +1303,33 @@ QList<Path> *NetModel::getFullPathes()
     return fullPathes;
 }
 
+const NetSnapshot &NetModel::getSnapshot()
+{
+    return getSchedule()->snapshot();
+}
+
+CpmEngine *NetModel::getSchedule()
+{
+    if (!schedule)
+        schedule = new CpmEngine(NetSnapshot(events, operations));
+    return schedule;
+}
+
 double NetModel::getCriticalPathWeight()
 {
-    double w = 0;
-    QList<Path> *pathes = getCriticalPathes();
-    if (pathes->count()>0)
-        w = pathes->first().weight();
-    return w;
+    return getSchedule()->length();
 }
 
-double NetModel::getEarlyEndTime(Event *i)
+double NetModel::getEarlyEndTime(Event *e)
 {
-    return getMaxPathWeight(getBeginEvent(), i);
+    int i = getSnapshot().indexOf(e);
+    return i != -1 ? getSchedule()->earlyTime(i) : 0;
 }
 
-double NetModel::getLaterEndTime(Event *i)
+double NetModel::getLaterEndTime(Event *e)
 {
-    return getCriticalPathWeight()-getMaxPathWeight(i, getEndEvent());
+    int i = getSnapshot().indexOf(e);
+    return i != -1 ? getSchedule()->laterTime(i) : getCriticalPathWeight();
 }
 
 double NetModel::getEarlyStartTime(Operation *o)
@@ -779,40 +1372,116 @@ double NetModel::getFreeReserveTime(Operation *o)
     return getEarlyEndTime(o->getEndEvent())-getEarlyEndTime(o->getBeginEvent())-o->getWaitTime();
 }
 
-bool NetModel::setN(Event *e, int n)
+const NetMetrics *NetModel::getMetrics()
 {
-    if (n<0)
-        return false;
-    foreach (Event *event, events)
+    if (!metrics)
+        metrics = calcMetrics();
+    return metrics;
+}
+
+// The metrics of an incorrect net are empty, like its other analyses.
+NetMetrics *NetModel::calcMetrics()
+{
+    NetMetrics *m = new NetMetrics;
+    if (!isCorrect())
+        return m;
+    CpmEngine *cpm = getSchedule();
+    const NetSnapshot &net = cpm->snapshot();
+    m->length = cpm->length();
+
+    QList<Event*> *sortedEvents = getSortedEvents();
+    int n = sortedEvents->count();
+    m->events.reserve(n);
+    m->eventEarly.reserve(n);
+    m->eventLater.reserve(n);
+    m->eventReserve.reserve(n);
+    foreach (Event *e, *sortedEvents)
     {
-        if (event->getN()==n)
-            return false;
+        int i = net.indexOf(e);
+        double early = cpm->earlyTime(i);
+        double later = cpm->laterTime(i);
+        m->events << e;
+        m->eventEarly << early;
+        m->eventLater << later;
+        m->eventReserve << later - early;
     }
+    delete sortedEvents;
+
+    const QVector<double> &factors = getIntensityFactors();
+    QList<Operation*> *sortedOperations = getSortedOperatioins();
+    int count = sortedOperations->count();
+    m->operations.reserve(count);
+    m->duration.reserve(count);
+    m->earlyStart.reserve(count);
+    m->laterStart.reserve(count);
+    m->earlyEnd.reserve(count);
+    m->laterEnd.reserve(count);
+    m->fullReserve.reserve(count);
+    m->freeReserve.reserve(count);
+    m->intensity.reserve(count);
+    foreach (Operation *o, *sortedOperations)
+    {
+        int a = net.indexOf(o);
+        double t = o->getWaitTime();
+        double beginEarly = 0, endEarly = 0, endLater = 0;
+        if (a != -1)
+        {
+            beginEarly = cpm->earlyTime(net.arcBegin(a));
+            endEarly = cpm->earlyTime(net.arcEnd(a));
+            endLater = cpm->laterTime(net.arcEnd(a));
+        }
+        m->operations << o;
+        m->duration << t;
+        m->earlyStart << beginEarly;
+        m->laterStart << endLater - t;
+        m->earlyEnd << beginEarly + t;
+        m->laterEnd << endLater;
+        m->fullReserve << endLater - (beginEarly + t);
+        m->freeReserve << endEarly - beginEarly - t;
+        m->intensity << (a != -1 ? factors[a] : 0);
+    }
+    delete sortedOperations;
+    return m;
+}
+
+bool NetModel::setN(Event *e, int n)
+{
+    if (n<0 || eventsByNumber.contains(n))
+        return false;
+    eventsByNumber.remove(e->getN());
+    ids.release(e->getN());
     e->setN(n);
+    eventsByNumber.insert(n, e);
+    ids.use(n);
+    delta.changedEvents.insert(e);
+    delta.numbersChanged = true;
     emit eventIdChanged(e, n);
-    emit updated();
+    notify();
     return true;
 }
 
 bool NetModel::setName(Event *e, const QString &name)
 {
     e->setName(name);
+    delta.changedEvents.insert(e);
+    delta.namesChanged = true;
     emit eventNameChanged(e, name);
-    emit updated();
+    notify();
     return true;
 }
 
 bool NetModel::setOperationEndEvent(Operation *o, Event *e)
 {
-    if (getOperationByEvents(o->getBeginEvent(), e))
+    if (getOperationByEvents(o->getBeginEvent(), e) || createsLoop(o->getBeginEvent(), e))
         return false;
     else
     {
         Event *old = o->getEndEvent();
         disconnect(o, old);
         connect(o, e);
+        delta.changedOperations.insert(o);
         emit operationEndEventChanged(o, old);
-        emit updated();
+        notify();
         return true;
     }
 }
@@ -820,8 +1489,10 @@ bool NetModel::setOperationEndEvent(Operation *o, Event *e)
 bool NetModel::setOperationName(Operation *o, const QString &name)
 {
     o->setName(name);
+    delta.changedOperations.insert(o);
+    delta.namesChanged = true;
     emit operationNameChanged(o, name);
-    emit updated();
+    notify();
     return true;
 }
 
@@ -829,44 +1500,116 @@ bool NetModel::setOperationWaitTime(Operation *o, double twait)
 {
     if (twait>=0)
     {
+        // an operation without a spread of estimates keeps none,
+        // otherwise the spread is widened to hold the new time
+        if (o->getMinTime()==o->getWaitTime() && o->getMaxTime()==o->getWaitTime())
+        {
+            o->setMinTime(twait);
+            o->setMaxTime(twait);
+        }
+        if (o->getMinTime()>twait)
+        {
+            o->setMinTime(twait);
+            delta.estimatesChanged = true;
+        }
+        if (o->getMaxTime()<twait)
+        {
+            o->setMaxTime(twait);
+            delta.estimatesChanged = true;
+        }
         o->setWaitTime(twait);
-        cmanager->reset(o->getBeginEvent());
+        if (schedule)
+        {
+            int a = schedule->snapshot().indexOf(o);
+            if (a != -1)
+                schedule->setDuration(a, twait);
+        }
+        ++version;
+        intensities.clear();
+        dropSimulation();
+        if (pert)
+        {
+            delete pert;
+            pert = NULL;
+        }
+        delta.changedOperations.insert(o);
+        delta.durationsChanged = true;
         emit operationWaitTimeChanged(o, twait);
-        emit updated();
+        notify();
+        return true;
+    }
+    else
+        return false;
+}
+
+// The optimistic time can not exceed the most likely one.
+bool NetModel::setOperationMinTime(Operation *o, double tmin)
+{
+    if (tmin>=0 && tmin<=o->getWaitTime())
+    {
+        o->setMinTime(tmin);
+        estimatesChanged(o);
         return true;
     }
     else
         return false;
 }
 
+// The pessimistic time can not be less than the most likely one.
+bool NetModel::setOperationMaxTime(Operation *o, double tmax)
+{
+    if (tmax>=0 && tmax>=o->getWaitTime())
+    {
+        o->setMaxTime(tmax);
+        estimatesChanged(o);
+        return true;
+    }
+    else
+        return false;
+}
+
+void NetModel::estimatesChanged(Operation *o)
+{
+    dropSimulation();
+    if (pert)
+    {
+        delete pert;
+        pert = NULL;
+    }
+    delta.changedOperations.insert(o);
+    delta.estimatesChanged = true;
+    emit operationEstimatesChanged(o);
+    notify();
+}
+
 bool NetModel::addEvent()
 {
-    Event *e = new Event(generateId());
+    Event *e = createEvent(generateId());
     if (add(e))
     {
         emit afterEventAdd();
-        emit updated();
+        notify();
         return true;
     }
     else
     {
-        delete e;
+        destroyEvent(e);
         return false;
     }
 }
 
 bool NetModel::insertEvent(int i)
 {
-    Event *e = new Event(generateId());
+    Event *e = createEvent(generateId());
     if (insert(i, e))
     {
         emit afterEventInsert(i);
-        emit updated();
+        notify();
         return true;
     }
     else
     {
-        delete e;
+        destroyEvent(e);
         return false;
     }
 }
@@ -876,7 +1619,7 @@ bool NetModel::removeEvent(Event *e)
     emit beforeEventDelete(e);
     if (remove(e))
     {
-        emit updated();
+        notify();
         return true;
     }
     else
@@ -888,7 +1631,7 @@ bool NetModel::addOperation(Operation *o)
     if (add(o))
     {
         emit afterOperationAdd(o);
-        emit updated();
+        notify();
         return true;
     }
     else
@@ -900,9 +1643,12 @@ bool NetModel::insertOperation(Operation *o, int i)
     if (add(o))
     {
         if (o->beginEvent)
+        {
             o->beginEvent->insertOutOperation(o, i);
+            updateDegree(o->beginEvent);
+        }
         emit afterOperationInsert(o, i);
-        emit updated();
+        notify();
         return true;
     }
     else
@@ -914,24 +1660,96 @@ bool NetModel::removeOperation(Operation *o)
     emit beforeOperationDelete(o);
     if (remove(o))
     {
-        emit updated();
+        notify();
         return true;
     }
     else
         return false;
 }
 
-int NetModel::generateId()
+// Removes the events with all their operations and the operations
+// in one pass over the lists. Views are told about all the removed
+// items at once by beforeItemsDelete, while the lists are unchanged.
+void NetModel::removeItems(const QList<Event*> &removedEvents, const QList<Operation*> &removedOperations)
 {
-    QSet<int> set;
+    QSet<Event*> eventSet;
+    QSet<Operation*> operationSet;
+    foreach (Event *e, removedEvents)
+    {
+        if (eventsByNumber.value(e->getN())!=e)
+            continue;
+        eventSet.insert(e);
+        foreach (Operation *o, e->getInOperations())
+            if (o->registered)
+                operationSet.insert(o);
+        foreach (Operation *o, e->getOutOperations())
+            if (o->registered)
+                operationSet.insert(o);
+    }
+    foreach (Operation *o, removedOperations)
+    {
+        if (o->registered)
+            operationSet.insert(o);
+    }
+    if (eventSet.isEmpty() && operationSet.isEmpty())
+        return;
+
+    QList<Operation*> keptOperations, removedOperationList;
+    keptOperations.reserve(operations.count()-operationSet.count());
+    foreach (Operation *o, operations)
+    {
+        if (operationSet.contains(o))
+            removedOperationList << o;
+        else
+            keptOperations << o;
+    }
+    QList<Event*> keptEvents, removedEventList;
+    keptEvents.reserve(events.count()-eventSet.count());
     foreach (Event *e, events)
-        set += e->getN();
-    for (int i = 0; i <= std::numeric_limits<int>::max(); ++i)
     {
-        if (!set.contains(i))
-            return i;
+        if (eventSet.contains(e))
+            removedEventList << e;
+        else
+            keptEvents << e;
+    }
+    emit beforeItemsDelete(removedEventList, removedOperationList);
+
+    // the lists are compacted first, so that release never meets
+    // an already deleted operation in them
+    operations = keptOperations;
+    // the output operations of an event keep their order, so every
+    // event is compacted in one pass before the operations leave it
+    QSet<Event*> beginEvents;
+    foreach (Operation *o, removedOperationList)
+    {
+        if (o->getBeginEvent())
+            beginEvents.insert(o->getBeginEvent());
+    }
+    foreach (Event *e, beginEvents)
+    {
+        QList<Operation*> kept;
+        foreach (Operation *o, e->getOutOperations())
+        {
+            if (!operationSet.contains(o))
+                kept << o;
+        }
+        e->getOutOperations() = kept;
     }
-    return std::numeric_limits<int>::max();
+    foreach (Operation *o, removedOperationList)
+        clearBeginEvent(o);
+    foreach (Event *e, beginEvents)
+        updateDegree(e);
+    foreach (Operation *o, removedOperationList)
+        release(o);
+    events = keptEvents;
+    foreach (Event *e, removedEventList)
+        release(e);
+    notify();
+}
+
+int NetModel::generateId()
+{
+    return ids.next();
 }
 
 QDataStream &NetModel::writeEvent(Event *e, QDataStream &stream)
@@ -948,7 +1766,7 @@ QDataStream &NetModel::readEvent(Event **e, QDataStream &stream)
     stream >> n >> name >> point;
     if (stream.status()==QDataStream::Ok)
     {
-        *e = new Event(n);
+        *e = createEvent(n);
         (*e)->setName(name);
         (*e)->getPoint()=point;
     }
@@ -968,18 +1786,22 @@ QDataStream &NetModel::writeOperation(Operation *o, QDataStream &stream)
     else
         stream << -1;
     stream << o->getWaitTime() << o->getName();
+    stream << o->getMinTime() << o->getMaxTime();
     return stream;
 }
 
-QDataStream &NetModel::readOperation(Operation **o, QDataStream &stream)
+QDataStream &NetModel::readOperation(Operation **o, QDataStream &stream, int format)
 {
     int begin, end;
     double twait;
     QString name;
     stream >> begin >> end >> twait >> name;
+    double tmin = twait, tmax = twait;
+    if (format >= 2)
+        stream >> tmin >> tmax;
     if (stream.status()==QDataStream::Ok)
     {
-        *o = new Operation();
+        *o = createOperation();
         if (begin==-1)
             connect(NULL, *o);
         else
@@ -990,14 +1812,21 @@ QDataStream &NetModel::readOperation(Operation **o, QDataStream &stream)
             connect(*o, getEventByNumber(end));
         (*o)->setName(name);
         (*o)->setWaitTime(twait);
+        (*o)->setMinTime(tmin);
+        (*o)->setMaxTime(tmax);
     }
     else
         *o = NULL;
     return stream;
 }
 
+// Streams of the first format begin with the count of events, later
+// ones with the negated number of the format.
+static const int streamFormat = 2;
+
 QDataStream &NetModel::writeTo(QDataStream &stream)
 {
+    stream << -streamFormat;
     stream << events.count();
     stream << operations.count();
     foreach (Event *e, events)
@@ -1013,8 +1842,17 @@ QDataStream &NetModel::writeTo(QDataStream &stream)
 
 QDataStream &NetModel::readFrom(QDataStream &stream)
 {
+    int format = 1;
     int eventscount, operationscount;
-    stream >> eventscount >> operationscount;
+    stream >> eventscount;
+    if (eventscount < 0)
+    {
+        format = -eventscount;
+        stream >> eventscount;
+    }
+    stream >> operationscount;
+    if (format > streamFormat)
+        stream.setStatus(QDataStream::ReadCorruptData);
     if (stream.status()==QDataStream::Ok)
     {
         for (int i = 0; i < eventscount; ++i)
@@ -1026,10 +1864,12 @@ QDataStream &NetModel::readFrom(QDataStream &stream)
         for (int i = 0; i < operationscount; ++i)
         {
             Operation *o;
-            readOperation(&o, stream);
+            readOperation(&o, stream, format);
             add(o);
         }
         updateCriticalPath();
+        // views are set to the loaded model anew
+        delta.clear();
     }
     return stream;
 }
@@ -1037,29 +1877,31 @@ QDataStream &NetModel::readFrom(QDataStream &stream)
 void NetModel::clear()
 {
     emit beforeClear();
-    qDeleteAll(events);
-    events.clear();
-    qDeleteAll(operations);
-    operations.clear();
+    clearCache();
+    invalidate();
+    destroyAll();
+    sources.clear();
+    sinks.clear();
+    isolated.clear();
+    orderValid = true;
+    nextOrder = 0;
+    eventsByNumber.clear();
+    operationsByEvents.clear();
+    duplicates = 0;
+    unconnected = 0;
+    ids.clear();
+    delta.clear();
+    analysisVersion = -1;
+    simulated = false;
 }
 
 bool NetModel::inCriticalPath(Operation *o)
 {
     if (isCorrect())
     {
-        QList<Path> *pathes = getCriticalPathes();
-
-        bool contains = false;
-        foreach (Path path, *pathes)
-        {
-            if (path.contains(o))
-            {
-                contains = true;
-                break;
-            }
-        }
-
-        return contains;
+        CpmEngine *cpm = getSchedule();
+        int a = cpm->snapshot().indexOf(o);
+        return a != -1 && cpm->isCritical(a);
     }
     else
         return false;
@@ -1074,57 +1916,185 @@ double NetModel::getIntensityFactor(Operation *operation)
         return 1;
     }
 
-    // Ищем все пути в графе (они кэшируются, поэтому
-    // не волнуемся за производительность).
-    QList<Path> *pathes = new QList<Path>;
-    Event *begin, *end;
-    getBeginEndEvents(&begin, &end);
-    getPathes(begin, end, pathes);
+    // Максимальный путь через работу и его пересечение с
+    // критическим путем считаются за два прохода по сети
+    // сразу для всех работ, без перебора путей.
+    int a = getSnapshot().indexOf(operation);
+    return a != -1 ? getIntensityFactors()[a] : 0;
+}
 
-    // Ищем максимальный путь, проходящий через
-    // заданную работу.
-    double tmax = 0;
-    Path pmax;
-    foreach (Path p, *pathes)
+// The estimates are gathered into arrays once, the kernels then work
+// on the arrays only.
+void NetModel::getEstimates(const NetSnapshot &net, QVector<double> &optimistic,
+                            QVector<double> &pessimistic)
+{
+    int m = net.arcCount();
+    optimistic.resize(m);
+    pessimistic.resize(m);
+    for (int a = 0; a < m; ++a)
     {
-        if (p.contains(operation) && p.weight() > tmax)
-        {
-            tmax = p.weight();
-            pmax = p;
-        }
+        optimistic[a] = net.operation(a)->getMinTime();
+        pessimistic[a] = net.operation(a)->getMaxTime();
     }
+}
 
-    // Если максимальный путь имеет продолжительность 0,
-    // то и коэффициент равен 0.
-    double factor = 0;
-    if (tmax > 0)
+const PertEngine *NetModel::getPert()
+{
+    if (!pert)
     {
-        // Пересечение максимального пути, проходящего через
-        // заданную работу, с критическим путем.
-        double t1cr = 0;
-        for (int i = 0; i < pmax.events.count() - 1; ++i)
+        const NetSnapshot &net = getSnapshot();
+        QVector<double> optimistic, pessimistic;
+        getEstimates(net, optimistic, pessimistic);
+        pert = new PertEngine;
+        pert->calculate(net, optimistic, pessimistic);
+    }
+    return pert;
+}
+
+double NetModel::getExpectedTime(Operation *operation)
+{
+    int a = getSnapshot().indexOf(operation);
+    return a != -1 ? getPert()->expected(a) : 0;
+}
+
+double NetModel::getTimeVariance(Operation *operation)
+{
+    int a = getSnapshot().indexOf(operation);
+    return a != -1 ? getPert()->variance(a) : 0;
+}
+
+// A net with loops has no completion time, the result is empty then.
+// Otherwise the criticality indexes are stored in the operations and
+// announced by modelChanged().
+SimulationResult NetModel::simulate(int iterations, quint64 seed, bool triangular)
+{
+    CpmEngine *cpm = getSchedule();
+    if (!cpm->isAcyclic() || iterations <= 0)
+        return SimulationResult();
+    const NetSnapshot &net = cpm->snapshot();
+    QVector<double> optimistic, pessimistic;
+    getEstimates(net, optimistic, pessimistic);
+    MonteCarloEngine engine(*cpm, optimistic, pessimistic,
+                            triangular ? MonteCarloEngine::Triangular : MonteCarloEngine::BetaPert);
+    SimulationResult result = engine.run(iterations, seed);
+    foreach (Operation *o, operations)
+        o->criticality = -1;
+    for (int a = 0; a < net.arcCount(); ++a)
+        net.operation(a)->criticality = result.criticality[a];
+    simulated = true;
+    delta.criticalityIndexChanged = true;
+    notify();
+    return result;
+}
+
+double NetModel::getCriticalityIndex(Operation *operation)
+{
+    return simulated ? operation->criticality : -1;
+}
+
+// Wait times are the normal durations. Options that can not be met
+// are rejected with an invalid plan.
+CrashingPlan NetModel::planCrashing(const QHash<Operation*, CrashOption> &options, double target)
+{
+    CpmEngine *cpm = getSchedule();
+    if (!cpm->isAcyclic())
+        return CrashingPlan();
+    const NetSnapshot &net = cpm->snapshot();
+    int m = net.arcCount();
+    QVector<double> crashTimes(m), costSlopes(m, 0);
+    for (int a = 0; a < m; ++a)
+    {
+        crashTimes[a] = net.duration(a);
+        QHash<Operation*, CrashOption>::const_iterator it = options.constFind(net.operation(a));
+        if (it == options.constEnd())
+            continue;
+        const CrashOption &option = it.value();
+        if (option.costSlope < 0 || option.crashTime < 0 || option.crashTime > net.duration(a))
         {
-            foreach (Operation *o, pmax.events[i]->getOutOperations())
-            {
-                if (o->getEndEvent() == pmax.events[i+1])
-                {
-                    if (o->inCriticalPath())
-                    {
-                        t1cr += o->getWaitTime();
-                    }
-
-                    break;
-                }
-            }
+            CrashingPlan plan;
+            plan.valid = false;
+            return plan;
         }
+        crashTimes[a] = option.crashTime;
+        costSlopes[a] = option.costSlope;
+    }
+    CrashingOptimizer optimizer(*cpm, crashTimes, costSlopes);
+    return optimizer.run(target);
+}
 
-        // Продолжительность критического пути.
-        double tcr = getCriticalPathWeight();
+void NetModel::dropSimulation()
+{
+    if (simulated)
+    {
+        simulated = false;
+        delta.criticalityIndexChanged = true;
+    }
+}
 
-        // Считаем по формуле.
-        factor = (tmax - t1cr) / (tcr - t1cr);
+// Evaluates one scenario on a copy of the schedule. Copies share the
+// arrays of the net until the durations are changed.
+struct ScenarioEvaluator
+{
+    typedef ScenarioResult result_type;
+    const CpmEngine *base;
+    ScenarioEvaluator(const CpmEngine *base) : base(base) {}
+    ScenarioResult operator()(const QHash<int, double> &durations) const
+    {
+        CpmEngine cpm(*base);
+        // a few changes are propagated incrementally,
+        // many are cheaper to calculate anew
+        if (durations.count() * 8 > cpm.snapshot().arcCount())
+        {
+            NetSnapshot net = cpm.snapshot();
+            for (QHash<int, double>::const_iterator it = durations.constBegin();
+                 it != durations.constEnd(); ++it)
+                net.setDuration(it.key(), it.value());
+            cpm.calculate(net);
+        }
+        else
+        {
+            for (QHash<int, double>::const_iterator it = durations.constBegin();
+                 it != durations.constEnd(); ++it)
+                cpm.setDuration(it.key(), it.value());
+        }
+        ScenarioResult result;
+        result.length = cpm.length();
+        const NetSnapshot &net = cpm.snapshot();
+        result.floats.reserve(net.arcCount());
+        for (int a = 0; a < net.arcCount(); ++a)
+            result.floats.insert(net.operation(a), cpm.totalFloat(a));
+        return result;
     }
+};
+
+// Every scenario gives new durations for some operations, the others
+// keep theirs. Scenarios are evaluated in parallel over the current
+// schedule, the model itself is not changed.
+QList<ScenarioResult> NetModel::evaluateScenarios(const QList< QHash<Operation*, double> > &scenarios)
+{
+    CpmEngine *cpm = getSchedule();
+    const NetSnapshot &net = cpm->snapshot();
+    QList< QHash<int, double> > durations;
+    durations.reserve(scenarios.count());
+    for (int s = 0; s < scenarios.count(); ++s)
+    {
+        const QHash<Operation*, double> &scenario = scenarios[s];
+        QHash<int, double> d;
+        for (QHash<Operation*, double>::const_iterator it = scenario.constBegin();
+             it != scenario.constEnd(); ++it)
+        {
+            int a = net.indexOf(it.key());
+            if (a != -1)
+                d.insert(a, it.value());
+        }
+        durations << d;
+    }
+    return QtConcurrent::blockingMapped< QList<ScenarioResult> >(durations, ScenarioEvaluator(cpm));
+}
 
-    delete pathes;
-    return factor;
+const QVector<double> &NetModel::getIntensityFactors()
+{
+    if (intensities.isEmpty())
+        intensities = getSchedule()->intensityFactors();
+    return intensities;
 }
@@ -3,21 +3,41 @@
 
 #include <QObject>
 #include <QList>
+#include <QSet>
+#include <QMap>
+#include <QHash>
+#include <QPair>
 #include <QString>
 #include <QDebug>
 #include <QMetaType>
 #include <QPoint>
 #include <QDataStream>
+#include <QAtomicInt>
+#include <QVector>
+#include "idallocator.h"
+#include "objectpool.h"
+#include "modeldelta.h"
 
 class Operation;
 class NetModel;
-class CacheManager;
+class CpmEngine;
+class NetSnapshot;
+struct NetMetrics;
+struct NetDiagnostics;
+struct CpmResult;
+struct ScenarioResult;
+class PertEngine;
+struct SimulationResult;
+struct CrashOption;
+struct CrashingPlan;
 
 class Event
 {
 private:
     QList<Operation*> inputOperations, outputOperations;
     int n;
+    // position in the online topological order kept by NetModel
+    int order;
     QString name;
     QPoint point;
     Event();
@@ -25,8 +45,6 @@ private:
     void setN(int n) {this->n=n;}
     void addInOperation(Operation*);
     void addOutOperation(Operation*);
-    void insertInOperation(Operation *o, int i) {inputOperations.insert(i, o);}
-    bool hasEdge(Event*);
     void setName(const QString &name) {this->name=name;}
     friend class NetModel;
 public:
@@ -51,8 +69,18 @@ private:
     double tmin, tmax, twait;
     QString name;
     void setWaitTime(double twait) {this->twait=twait;}
+    void setMinTime(double tmin) {this->tmin=tmin;}
+    void setMaxTime(double tmax) {this->tmax=tmax;}
     void setName(const QString &name) {this->name=name;}
     bool _inCriticalPath;
+    // added to a model, such operations are indexed by their events
+    bool registered;
+    // allocated by NetModel::createOperation
+    bool pooled;
+    // position in the input operations of the end event
+    int inSlot;
+    // set by NetModel::simulate
+    double criticality;
     friend class NetModel;
 public:
     Operation();
@@ -62,6 +90,10 @@ public:
     void setBeginEvent(Event* e);
     void setEndEvent(Event* e);
     double getWaitTime();
+    // optimistic and pessimistic times of PERT, the wait time is
+    // the most likely one
+    double getMinTime() {return tmin;}
+    double getMaxTime() {return tmax;}
     QString getCode() const;
     QString getName() {return name;}
     bool inCriticalPath() const {return _inCriticalPath;}
@@ -78,6 +110,7 @@ public:
     QList<Event*> events;
     Path() { }
     Path(QList<Event*> events);
+    Path(const QList<Event*> &events, double weight);
     QString code() const {return _code;}
     double weight() const {return _weight;}
     bool contains(Operation *o) const
@@ -133,32 +166,100 @@ public:
     }
 };
 
+// Receives paths from NetModel::enumeratePathes one by one.
+class PathVisitor
+{
+public:
+    virtual ~PathVisitor() {}
+    // returns false to stop the enumeration
+    virtual bool visit(const Path &path) = 0;
+};
+
 class NetModel : public QObject
 {
     Q_OBJECT
 private:
     QList<Event*> events;
     QList<Operation*> operations;
-    QList<Path> *getMaxPathes(Event *, Event *);
-    double getMaxPathWeight(Event *, Event *);
-    void getPathes(Event *, Event *, QList<Path> *);
     bool add(Operation *);
     bool remove(Operation *);
     bool add(Event *);
     bool insert(int, Event *);
     bool remove(Event *);
+    void clearBeginEvent(Operation *);
     QDataStream &writeEvent(Event *e, QDataStream &stream);
     QDataStream &readEvent(Event **e, QDataStream &stream);
     QDataStream &writeOperation(Operation *o, QDataStream &stream);
-    QDataStream &readOperation(Operation **o, QDataStream &stream);
+    QDataStream &readOperation(Operation **o, QDataStream &stream, int format);
     int generateId();
+    IdAllocator ids;
+    // events and operations are placed in slabs owned by the model
+    ObjectPool<Event> eventPool;
+    ObjectPool<Operation> operationPool;
+    Event *createEvent(int n);
+    void destroyEvent(Event *);
+    void destroyAll();
+    void release(Event *);
+    void release(Operation *);
 private:
     QList<Path> *fullPathes;
     QList<Path> *criticPathes;
     void clearCache();
     QList<Path> *_getFullPathes();
     QList<Path> *_getCriticalPathes();
-    CacheManager *cmanager;
+    CpmEngine *schedule;
+    CpmEngine *getSchedule();
+    void invalidate();
+    NetMetrics *metrics;
+    NetMetrics *calcMetrics();
+    NetDiagnostics *diagnostics;
+    NetDiagnostics *calcDiagnostics();
+    // events without input, without output and without any operations
+    QSet<Event*> sources, sinks, isolated;
+    void updateDegree(Event *);
+    // operations of the model with an unconnected end
+    int unconnected;
+    bool isUnconnected(Operation *o) const
+    {
+        return o->registered && (!o->getBeginEvent() || !o->getEndEvent());
+    }
+    // online topological order of events (Pearce-Kelly), valid while
+    // the net has no loops
+    bool orderValid;
+    int nextOrder;
+    void addArc(Event *, Event *);
+    void rebuildOrder();
+    bool reaches(Event *from, Event *to, int bound, QMap<int, Event*> *region);
+    // indexes for getEventByNumber and getOperationByEvents,
+    // duplicates counts operations with the same events left out
+    QHash<int, Event*> eventsByNumber;
+    QHash<QPair<Event*, Event*>, Operation*> operationsByEvents;
+    int duplicates;
+    void indexOperation(Operation *);
+    void unindexOperation(Operation *);
+    int transactions;
+    bool pending;
+    void notify();
+    // changes since the last modelChanged()
+    ModelDelta delta;
+    void flush();
+    void emitDelta();
+    // analysis in the background: version is changed with the schedule,
+    // analysisVersion is the version being analysed or -1
+    bool async;
+    int version;
+    int analysisVersion;
+    void startAnalysis();
+    void markCriticalPath();
+    QVector<double> intensities;
+    const QVector<double> &getIntensityFactors();
+    PertEngine *pert;
+    void getEstimates(const NetSnapshot &, QVector<double> &, QVector<double> &);
+    void estimatesChanged(Operation *);
+    // criticality indexes of operations are set by the last simulation
+    // while the schedule and estimates stay the same
+    bool simulated;
+    void dropSimulation();
 public:
     NetModel();
     ~NetModel();
@@ -173,6 +274,8 @@ public:
     // checkers
     bool inCriticalPath(Operation *);
     bool hasLoops();
+    bool createsLoop(Event *, Event *);
+    QList<Event*> getLoop();
     bool hasMultiEdges();
     bool hasOneBeginEvent();
     bool hasOneEndEvent();
@@ -180,18 +283,26 @@ public:
     bool hasUnconnectedOperations();
     bool isCorrect();
     bool isCorrect(QString &);
+    const NetDiagnostics *getDiagnostics();
     // getters
+    const NetSnapshot &getSnapshot();
     QList<Operation*> *getOperations() {return &operations;}
     QList<Event*> *getEvents() {return &events;}
     int getEventsCount() {return events.count();}
     Event *event(int i) {return i>=0&&i<events.count()?events[i]:NULL;}
     Event *first() {return events.isEmpty()?NULL:events.first();}
     Event *last() {return events.isEmpty()?NULL:events.last();}
+    Operation *createOperation(double twait = 0);
+    void destroyOperation(Operation *);
     // for net
     void sort(QList<Path> &);
     void qsort(QList<Path> &);
     QList<Event*> *getSortedEvents();
     QList<Operation*> *getSortedOperatioins();
+    int enumeratePathes(PathVisitor *visitor, int maxCount = -1, double minWeight = 0,
+                        const QAtomicInt *cancel = NULL);
+    quint64 countPathes();
+    QList<Path> getLongestPathes(int k);
     QList<Path> *getFullPathes();
     QList<Path> *getCriticalPathes();
     double getCriticalPathWeight();
@@ -207,7 +318,30 @@ public:
     double getFreeReserveTime(Operation*);
 
     double getIntensityFactor(Operation *);
+    // empty when the net is not correct
+    const NetMetrics *getMetrics();
+    const PertEngine *getPert();
+    double getExpectedTime(Operation *);
+    double getTimeVariance(Operation *);
+    // Monte Carlo simulation of the completion time with durations of
+    // the beta (PERT) or the triangular distribution
+    SimulationResult simulate(int iterations, quint64 seed = 1, bool triangular = false);
+    bool hasCriticalityIndex() const {return simulated;}
+    // share of simulated iterations in which the operation was critical,
+    // -1 without a simulation
+    double getCriticalityIndex(Operation *);
+    // cheapest crashing of operations to finish by the target time,
+    // operations without options are not shortened; the model is
+    // not changed
+    CrashingPlan planCrashing(const QHash<Operation*, CrashOption> &options, double target);
+    QList<ScenarioResult> evaluateScenarios(const QList< QHash<Operation*, double> > &scenarios);
 public:
+    void beginTransaction();
+    void commit();
+    // calculate the schedule after structural changes in a background
+    // thread, modelChanged() is emitted when it is ready
+    void setAsync(bool);
+    bool isAsync() const {return async;}
     void connect(Event*,Operation*);
     void connect(Operation*,Event*);
     void connect(Event*,Operation*,Event*);
@@ -220,15 +354,19 @@ public slots:
     bool setOperationEndEvent(Operation *, Event *);
     bool setOperationName(Operation *, const QString &);
     bool setOperationWaitTime(Operation *, double);
+    bool setOperationMinTime(Operation *, double);
+    bool setOperationMaxTime(Operation *, double);
     bool addEvent();
     bool removeEvent(Event *);
     bool addOperation(Operation *);
     bool removeOperation(Operation *);
+    void removeItems(const QList<Event*> &, const QList<Operation*> &);
     bool insertEvent(int);
     bool insertOperation(Operation *, int);
-    void update() {emit updated();}
+    void update() {delta.structureChanged = true; notify();}
 private slots:
     void updateCriticalPath();
+    void analysisFinished(const CpmResult &);
 signals:
     void beforeClear();
     void eventIdChanged(Event *, int);
@@ -236,13 +374,18 @@ signals:
     void operationEndEventChanged(Operation *, Event *);
     void operationNameChanged(Operation *, const QString &);
     void operationWaitTimeChanged(Operation *, double);
+    void operationEstimatesChanged(Operation *);
     void afterEventAdd();
     void beforeEventDelete(Event *);
     void afterOperationAdd(Operation *);
     void beforeOperationDelete(Operation *);
+    // emitted by removeItems once for all the items it removes
+    void beforeItemsDelete(const QList<Event*> &, const QList<Operation*> &);
     void afterEventInsert(int);
     void afterOperationInsert(Operation *, int);
     void updated();
+    // emitted after updated() with all changes since the last one
+    void modelChanged(const ModelDelta &);
 };
 
 #endif // NETMODEL_H
@@ -0,0 +1,61 @@
+#include "netsnapshot.h"
+
+NetSnapshot::NetSnapshot()
+{
+    _outOffsets.fill(0, 1);
+    _inOffsets.fill(0, 1);
+}
+
+NetSnapshot::NetSnapshot(const QList<Event*> &events, const QList<Operation*> &operations)
+{
+    int n = events.count();
+    _events.reserve(n);
+    eventIndex.reserve(n);
+    foreach (Event *e, events)
+    {
+        eventIndex.insert(e, _events.count());
+        _events << e;
+    }
+
+    _operations.reserve(operations.count());
+    _begins.reserve(operations.count());
+    _ends.reserve(operations.count());
+    _durations.reserve(operations.count());
+    foreach (Operation *o, operations)
+    {
+        int i = indexOf(o->getBeginEvent());
+        int j = indexOf(o->getEndEvent());
+        if (i != -1 && j != -1)
+        {
+            arcIndex.insert(o, _operations.count());
+            _operations << o;
+            _begins << i;
+            _ends << j;
+            _durations << o->getWaitTime();
+        }
+    }
+
+    // counting sort of arcs by begin and by end event
+    int m = _operations.count();
+    _outOffsets.fill(0, n + 1);
+    _inOffsets.fill(0, n + 1);
+    for (int a = 0; a < m; ++a)
+    {
+        ++_outOffsets[_begins[a] + 1];
+        ++_inOffsets[_ends[a] + 1];
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        _outOffsets[i + 1] += _outOffsets[i];
+        _inOffsets[i + 1] += _inOffsets[i];
+    }
+    _outArcs.fill(0, m);
+    _inArcs.fill(0, m);
+    QVector<int> outPos = _outOffsets;
+    QVector<int> inPos = _inOffsets;
+    for (int a = 0; a < m; ++a)
+    {
+        _outArcs[outPos[_begins[a]]++] = a;
+        _inArcs[inPos[_ends[a]]++] = a;
+    }
+}
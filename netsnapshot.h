@@ -0,0 +1,55 @@
+#ifndef NETSNAPSHOT_H
+#define NETSNAPSHOT_H
+
+#include "netmodel.h"
+#include <QHash>
+#include <QVector>
+
+// Immutable compressed sparse row copy of a net for analysis kernels.
+// Events get dense indices in the order of NetModel::getEvents(),
+// operations connected at both ends become arcs in the order of
+// NetModel::getOperations(). Arcs leaving event i are
+// outArc(outBegin(i))..outArc(outEnd(i)-1), entering arcs likewise.
+// All arrays are implicitly shared, so copying a snapshot is cheap.
+// Only durations may be patched after construction, copies made
+// before the patch keep the old values.
+class NetSnapshot
+{
+public:
+    NetSnapshot();
+    NetSnapshot(const QList<Event*> &events, const QList<Operation*> &operations);
+    int eventCount() const {return _events.count();}
+    int arcCount() const {return _operations.count();}
+    Event *event(int i) const {return _events[i];}
+    Operation *operation(int a) const {return _operations[a];}
+    int indexOf(Event *e) const {return eventIndex.value(e, -1);}
+    int indexOf(Operation *o) const {return arcIndex.value(o, -1);}
+    int arcBegin(int a) const {return _begins[a];}
+    int arcEnd(int a) const {return _ends[a];}
+    double duration(int a) const {return _durations[a];}
+    int outBegin(int i) const {return _outOffsets[i];}
+    int outEnd(int i) const {return _outOffsets[i+1];}
+    int outArc(int k) const {return _outArcs[k];}
+    int inBegin(int i) const {return _inOffsets[i];}
+    int inEnd(int i) const {return _inOffsets[i+1];}
+    int inArc(int k) const {return _inArcs[k];}
+    void setDuration(int a, double t) {_durations[a] = t;}
+    const QVector<int> &begins() const {return _begins;}
+    const QVector<int> &ends() const {return _ends;}
+    const QVector<double> &durations() const {return _durations;}
+    const QVector<int> &outOffsets() const {return _outOffsets;}
+    const QVector<int> &outArcs() const {return _outArcs;}
+    const QVector<int> &inOffsets() const {return _inOffsets;}
+    const QVector<int> &inArcs() const {return _inArcs;}
+private:
+    QVector<Event*> _events;
+    QVector<Operation*> _operations;
+    QHash<Event*, int> eventIndex;
+    QHash<Operation*, int> arcIndex;
+    QVector<int> _begins, _ends;
+    QVector<double> _durations;
+    QVector<int> _outOffsets, _outArcs;
+    QVector<int> _inOffsets, _inArcs;
+};
+
+#endif // NETSNAPSHOT_H
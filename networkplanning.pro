@@ -14,7 +14,18 @@ HEADERS = treeitem.h \
     arrow.h \
     diagramscene.h \
     aboutdialog.h \
-    cachemanager.h
+    cpmengine.h \
+    netsnapshot.h \
+    netmetrics.h \
+    netdiagnostics.h \
+    idallocator.h \
+    objectpool.h \
+    modeldelta.h \
+    cpmtask.h \
+    scenarioresult.h \
+    pertengine.h \
+    montecarlo.h \
+    crashing.h
 RESOURCES = networkplanning.qrc
 SOURCES = treeitem.cpp \
     treemodel.cpp \
@@ -33,7 +44,13 @@ SOURCES = treeitem.cpp \
     arrow.cpp \
     diagramscene.cpp \
     aboutdialog.cpp \
-    cachemanager.cpp
+    cpmengine.cpp \
+    netsnapshot.cpp \
+    idallocator.cpp \
+    cpmtask.cpp \
+    pertengine.cpp \
+    montecarlo.cpp \
+    crashing.cpp
 CONFIG += qt
 FORMS += mainwindow.ui \
     dialog.ui \
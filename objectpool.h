@@ -0,0 +1,72 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <QList>
+#include <new>
+
+// Memory for objects of one type, cut from slabs of slabSize objects.
+// Objects are constructed by placement new in allocate()d memory, and
+// destroyed memory is reused through a free list. release() gives all
+// slabs back at once, destructors must have been run before.
+template <class T>
+class ObjectPool
+{
+public:
+    explicit ObjectPool(int slabSize = 256) :
+            slabSize(slabSize), next(NULL), left(0), freeList(NULL)
+    {
+    }
+    ~ObjectPool()
+    {
+        release();
+    }
+    void *allocate()
+    {
+        if (freeList)
+        {
+            Slot *slot = freeList;
+            freeList = slot->next;
+            return slot;
+        }
+        if (left==0)
+        {
+            next = static_cast<char*>(::operator new(slabSize * slotSize()));
+            slabs << next;
+            left = slabSize;
+        }
+        void *p = next;
+        next += slotSize();
+        --left;
+        return p;
+    }
+    void free(void *p)
+    {
+        Slot *slot = static_cast<Slot*>(p);
+        slot->next = freeList;
+        freeList = slot;
+    }
+    void release()
+    {
+        foreach (char *slab, slabs)
+            ::operator delete(slab);
+        slabs.clear();
+        next = NULL;
+        left = 0;
+        freeList = NULL;
+    }
+private:
+    struct Slot
+    {
+        Slot *next;
+    };
+    static size_t slotSize() {return sizeof(T) > sizeof(Slot) ? sizeof(T) : sizeof(Slot);}
+    int slabSize;
+    QList<char*> slabs;
+    char *next;
+    int left;
+    Slot *freeList;
+    ObjectPool(const ObjectPool &);
+    ObjectPool &operator=(const ObjectPool &);
+};
+
+#endif // OBJECTPOOL_H
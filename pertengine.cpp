@@ -0,0 +1,62 @@
+#include "pertengine.h"
+#include <math.h>
+
+PertEngine::PertEngine() : _lengthVariance(0)
+{
+}
+
+bool PertEngine::calculate(const NetSnapshot &s, const QVector<double> &optimistic,
+                           const QVector<double> &pessimistic)
+{
+    int n = s.eventCount();
+    int m = s.arcCount();
+    const double *likely = s.durations().constData();
+    const double *a = optimistic.constData();
+    const double *b = pessimistic.constData();
+
+    // estimates out of order are widened to include the most likely time
+    _expected.resize(m);
+    _variance.resize(m);
+    double *te = _expected.data();
+    double *var = _variance.data();
+    for (int k = 0; k < m; ++k)
+    {
+        double lo = a[k] < likely[k] ? a[k] : likely[k];
+        double hi = b[k] > likely[k] ? b[k] : likely[k];
+        te[k] = (lo + 4 * likely[k] + hi) / 6;
+        var[k] = (hi - lo) * (hi - lo) / 36;
+    }
+
+    NetSnapshot net = s;
+    for (int k = 0; k < m; ++k)
+        net.setDuration(k, te[k]);
+    _lengthVariance = 0;
+    if (!cpm.calculate(net))
+        return false;
+
+    // variance of the longest path to every event, of several longest
+    // paths the one with the largest variance is taken
+    const int *begins = net.begins().constData();
+    const int *inOffsets = net.inOffsets().constData();
+    const int *inArcs = net.inArcs().constData();
+    QVector<double> pathVariance(n, 0);
+    foreach (int j, cpm.order())
+    {
+        double t = cpm.earlyTime(j);
+        for (int l = inOffsets[j]; l < inOffsets[j + 1]; ++l)
+        {
+            int k = inArcs[l];
+            if (qFuzzyCompare(cpm.earlyTime(begins[k]) + te[k] + 1.0, t + 1.0)
+                && pathVariance[begins[k]] + var[k] > pathVariance[j])
+                pathVariance[j] = pathVariance[begins[k]] + var[k];
+        }
+        if (qFuzzyCompare(t + 1.0, cpm.length() + 1.0) && pathVariance[j] > _lengthVariance)
+            _lengthVariance = pathVariance[j];
+    }
+    return true;
+}
+
+double PertEngine::deviation() const
+{
+    return sqrt(_lengthVariance);
+}
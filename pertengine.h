@@ -0,0 +1,32 @@
+#ifndef PERTENGINE_H
+#define PERTENGINE_H
+
+#include "cpmengine.h"
+#include <QVector>
+
+// Three-point (PERT) estimates over a net snapshot. The snapshot
+// durations are the most likely times m, optimistic a and pessimistic
+// b are given per arc: te = (a + 4m + b) / 6, var = ((b - a) / 6)^2.
+// The project mean is the length of the net with expected durations,
+// its variance is the sum along the critical path of that net.
+class PertEngine
+{
+public:
+    PertEngine();
+    bool calculate(const NetSnapshot &, const QVector<double> &optimistic,
+                   const QVector<double> &pessimistic);
+    const CpmEngine &schedule() const {return cpm;}
+    double expected(int a) const {return _expected[a];}
+    double variance(int a) const {return _variance[a];}
+    const QVector<double> &expectedDurations() const {return _expected;}
+    const QVector<double> &variances() const {return _variance;}
+    double length() const {return cpm.length();}
+    double lengthVariance() const {return _lengthVariance;}
+    double deviation() const;
+private:
+    QVector<double> _expected, _variance;
+    CpmEngine cpm;
+    double _lengthVariance;
+};
+
+#endif // PERTENGINE_H
@@ -0,0 +1,16 @@
+#ifndef SCENARIORESULT_H
+#define SCENARIORESULT_H
+
+#include "netmodel.h"
+#include <QHash>
+
+// Schedule of a net with some durations changed, see
+// NetModel::evaluateScenarios.
+struct ScenarioResult
+{
+    double length;
+    // total float of every connected operation
+    QHash<Operation*, double> floats;
+};
+
+#endif // SCENARIORESULT_H
@@ -20,6 +20,12 @@ public:
         delete childItems[position];
         childItems.removeAt(position);
     }
+    void removeChildren(int position, int count)
+    {
+        for (int i=position;i<position+count;++i)
+            delete childItems[i];
+        childItems.erase(childItems.begin()+position, childItems.begin()+position+count);
+    }
     void removeAllChilds()
     {
         qDeleteAll(childItems);
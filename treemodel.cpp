@@ -6,7 +6,8 @@ TreeModel::TreeModel(NetModel &netmodel, QObject *parent)
     : QAbstractItemModel(parent)
 {
     header.clear();
-    header << QString::fromUtf8("Код события") << QString::fromUtf8("Событие") << QString::fromUtf8("Код работы") << QString::fromUtf8("Работа") << QString::fromUtf8("Продолжительность");
+    header << QString::fromUtf8("Код события") << QString::fromUtf8("Событие") << QString::fromUtf8("Код работы") << QString::fromUtf8("Работа") << QString::fromUtf8("Продолжительность")
+           << QString::fromUtf8("Оптимистическая") << QString::fromUtf8("Пессимистическая");
     rootItem = new TreeItem();
     setModel(netmodel);
 }
@@ -25,6 +26,8 @@ void TreeModel::setModel(NetModel &netmodel)
             this, SLOT(operationNameChanged(Operation *, const QString &)));
     connect(this->netmodel, SIGNAL(operationWaitTimeChanged(Operation *, double)),
             this, SLOT(operationWaitTimeChanged(Operation *, double)));
+    connect(this->netmodel, SIGNAL(operationEstimatesChanged(Operation *)),
+            this, SLOT(operationEstimatesChanged(Operation *)));
     connect(this->netmodel, SIGNAL(afterEventAdd()),
             this, SLOT(afterEventAdd()));
     connect(this->netmodel, SIGNAL(beforeEventDelete(Event *)),
@@ -33,6 +36,8 @@ void TreeModel::setModel(NetModel &netmodel)
             this, SLOT(afterOperationAdd(Operation *)));
     connect(this->netmodel, SIGNAL(beforeOperationDelete(Operation *)),
             this, SLOT(beforeOperationDelete(Operation *)));
+    connect(this->netmodel, SIGNAL(beforeItemsDelete(const QList<Event*> &, const QList<Operation*> &)),
+            this, SLOT(beforeItemsDelete(const QList<Event*> &, const QList<Operation*> &)));
     connect(this->netmodel, SIGNAL(afterEventInsert(int)),
             this, SLOT(afterEventInsert(int)));
     connect(this->netmodel, SIGNAL(afterOperationInsert(Operation *, int)),
@@ -80,10 +85,10 @@ void TreeModel::addOperation(const QModelIndex &selected)
             Event *event = parentItem->getEvent();
             if (event)
             {
-                Operation *o = new Operation();
+                Operation *o = netmodel->createOperation();
                 o->setBeginEvent(event);
                 if (!netmodel->insertOperation(o, i))
-                    delete o;
+                    netmodel->destroyOperation(o);
             }
         }
     }
@@ -112,10 +117,10 @@ void TreeModel::insertOperation(const QModelIndex &selected)
             Event *event = parentItem->getEvent();
             if (event)
             {
-                Operation *o = new Operation();
+                Operation *o = netmodel->createOperation();
                 o->setBeginEvent(event);
                 if (!netmodel->insertOperation(o, i))
-                    delete o;
+                    netmodel->destroyOperation(o);
                 assert(parentItem->childCount()==event->getOutOperations().count());
             }
         }
@@ -128,20 +133,9 @@ void TreeModel::removeEvent(const QModelIndex &selected)
     {
         TreeItem *item = static_cast<TreeItem*>(selected.internalPointer());
         Event *e = item->getEvent();
+        // the operations of the event go away with it
         if (e)
-        {
-            QList<Operation*> in = e->getInOperations();
-            foreach (Operation* o, in)
-            {
-                netmodel->removeOperation(o);
-            }
-            QList<Operation*> out = e->getOutOperations();
-            foreach (Operation* o, out)
-            {
-                netmodel->removeOperation(o);
-            }
-            netmodel->removeEvent(e);
-        }
+            netmodel->removeItems(QList<Event*>() << e, QList<Operation*>());
     }
 }
 
@@ -221,7 +215,7 @@ QModelIndex TreeModel::getBottomRightModelIndex(Operation *o)
     int i = getIndex(o->getBeginEvent());
     int j = getIndex(o);
     if (i>-1 && j>-1)
-        return createIndex(j, 4, rootItem->child(i)->child(j));
+        return createIndex(j, 6, rootItem->child(i)->child(j));
     return QModelIndex();
 }
 
@@ -283,14 +277,28 @@ void TreeModel::operationNameChanged(Operation *o, const QString &)
     }
 }
 
+// The estimates follow the wait time while they are all the same.
 void TreeModel::operationWaitTimeChanged(Operation *o, double)
 {
     int i = getIndex(o->getBeginEvent());
     int j = getIndex(o);
     if (i!=-1 && j!=-1)
     {
-        QModelIndex index = createIndex(j, 4, rootItem->child(i)->child(j));
-        emit dataChanged(index, index);
+        QModelIndex first = createIndex(j, 4, rootItem->child(i)->child(j));
+        QModelIndex last = createIndex(j, 6, rootItem->child(i)->child(j));
+        emit dataChanged(first, last);
+    }
+}
+
+void TreeModel::operationEstimatesChanged(Operation *o)
+{
+    int i = getIndex(o->getBeginEvent());
+    int j = getIndex(o);
+    if (i!=-1 && j!=-1)
+    {
+        QModelIndex first = createIndex(j, 5, rootItem->child(i)->child(j));
+        QModelIndex last = createIndex(j, 6, rootItem->child(i)->child(j));
+        emit dataChanged(first, last);
     }
 }
 
@@ -344,6 +352,63 @@ void TreeModel::beforeOperationDelete(Operation *o)
     }
 }
 
+// Removes the given rows of an item, rows sorted ascending, one run
+// of adjacent rows at a time from the end.
+void TreeModel::removeRowRuns(const QModelIndex &parent, TreeItem *item, const QList<int> &rows)
+{
+    int last = rows.count()-1;
+    while (last>=0)
+    {
+        int first = last;
+        while (first>0 && rows[first-1]==rows[first]-1)
+            --first;
+        beginRemoveRows(parent, rows[first], rows[last]);
+        item->removeChildren(rows[first], rows[last]-rows[first]+1);
+        endRemoveRows();
+        last = first-1;
+    }
+}
+
+void TreeModel::beforeItemsDelete(const QList<Event*> &events, const QList<Operation*> &operations)
+{
+    QSet<Event*> eventSet = events.toSet();
+    QHash<Event*, int> eventRows;
+    for (int i=0;i<rootItem->childCount();++i)
+        eventRows.insert(rootItem->child(i)->getEvent(), i);
+
+    // operations of removed events go away with their rows
+    QSet<Operation*> operationSet;
+    QSet<int> parentRows;
+    foreach (Operation *o, operations)
+    {
+        Event *e = o->getBeginEvent();
+        if (!e || eventSet.contains(e) || !eventRows.contains(e))
+            continue;
+        operationSet.insert(o);
+        parentRows.insert(eventRows.value(e));
+    }
+    foreach (int i, parentRows)
+    {
+        TreeItem *parent = rootItem->child(i);
+        QList<int> rows;
+        for (int j=0;j<parent->childCount();++j)
+        {
+            if (operationSet.contains(parent->child(j)->getOperation()))
+                rows << j;
+        }
+        removeRowRuns(createIndex(i, 0, parent), parent, rows);
+    }
+
+    QList<int> rows;
+    foreach (Event *e, events)
+    {
+        if (eventRows.contains(e))
+            rows << eventRows.value(e);
+    }
+    qSort(rows);
+    removeRowRuns(QModelIndex(), rootItem, rows);
+}
+
 void TreeModel::afterEventInsert(int i)
 {
     Event *e = netmodel->event(i);
@@ -382,6 +447,8 @@ void TreeModel::beforeClear()
             this, SLOT(operationNameChanged(Operation *, const QString &)));
     disconnect(this->netmodel, SIGNAL(operationWaitTimeChanged(Operation *, double)),
             this, SLOT(operationWaitTimeChanged(Operation *, double)));
+    disconnect(this->netmodel, SIGNAL(operationEstimatesChanged(Operation *)),
+            this, SLOT(operationEstimatesChanged(Operation *)));
     disconnect(this->netmodel, SIGNAL(afterEventAdd()),
             this, SLOT(afterEventAdd()));
     disconnect(this->netmodel, SIGNAL(beforeEventDelete(Event *)),
@@ -390,6 +457,8 @@ void TreeModel::beforeClear()
             this, SLOT(afterOperationAdd(Operation *)));
     disconnect(this->netmodel, SIGNAL(beforeOperationDelete(Operation *)),
             this, SLOT(beforeOperationDelete(Operation *)));
+    disconnect(this->netmodel, SIGNAL(beforeItemsDelete(const QList<Event*> &, const QList<Operation*> &)),
+            this, SLOT(beforeItemsDelete(const QList<Event*> &, const QList<Operation*> &)));
     disconnect(this->netmodel, SIGNAL(afterEventInsert(int)),
             this, SLOT(afterEventInsert(int)));
     disconnect(this->netmodel, SIGNAL(afterOperationInsert(Operation *, int)),
@@ -406,7 +475,7 @@ TreeModel::~TreeModel()
 
 int TreeModel::columnCount(const QModelIndex &) const
 {
-    return 5;
+    return 7;
 }
 
 QVariant TreeModel::data(const QModelIndex &index, int role) const
@@ -434,6 +503,8 @@ QVariant TreeModel::data(const QModelIndex &index, int role) const
             case 2: return item->getOperation()->getCode();
             case 3: return item->getOperation()->getName();
             case 4: return item->getOperation()->getWaitTime();
+            case 5: return item->getOperation()->getMinTime();
+            case 6: return item->getOperation()->getMaxTime();
             default: return QVariant();
         }
     }
@@ -449,7 +520,7 @@ Qt::ItemFlags TreeModel::flags(const QModelIndex &index) const
         && static_cast<TreeItem*>(index.internalPointer())->getEvent())
         return //Qt::ItemIsDragEnabled | Qt::ItemIsDropEnabled |
                 Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable;
-    else if ((index.column()==2||index.column()==3||index.column()==4)
+    else if (index.column()>=2 && index.column()<=6
         && static_cast<TreeItem*>(index.internalPointer())->getOperation())
         return //Qt::ItemIsDragEnabled | Qt::ItemIsDropEnabled |
                 Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable;
@@ -490,6 +561,12 @@ bool TreeModel::setData(const QModelIndex &index, const QVariant &value, int rol
             case 4:
                 return (v.convert(QVariant::Double)
                     && netmodel->setOperationWaitTime(item->getOperation(), v.toDouble()));
+            case 5:
+                return (v.convert(QVariant::Double)
+                    && netmodel->setOperationMinTime(item->getOperation(), v.toDouble()));
+            case 6:
+                return (v.convert(QVariant::Double)
+                    && netmodel->setOperationMaxTime(item->getOperation(), v.toDouble()));
             default:
                 return false;
         }
@@ -49,16 +49,19 @@ private:
     QList<QVariant> header;
     int getIndex(Event *);
     int getIndex(Operation *);
+    void removeRowRuns(const QModelIndex &parent, TreeItem *item, const QList<int> &rows);
 private slots:
     void eventIdChanged(Event *, int);
     void eventNameChanged(Event *, const QString &);
     void operationEndEventChanged(Operation *, Event *);
     void operationNameChanged(Operation *, const QString &);
     void operationWaitTimeChanged(Operation *, double);
+    void operationEstimatesChanged(Operation *);
     void afterEventAdd();
     void beforeEventDelete(Event *);
     void afterOperationAdd(Operation *);
     void beforeOperationDelete(Operation *);
+    void beforeItemsDelete(const QList<Event*> &, const QList<Operation*> &);
     void afterEventInsert(int);
     void afterOperationInsert(Operation *, int);
     void updated();